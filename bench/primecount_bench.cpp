@@ -0,0 +1,408 @@
+///
+/// @file   primecount_bench.cpp
+/// @brief  Benchmark primecount's most important building blocks
+///         (Sieve::cross_off_count(), Sieve::count(), PiTable,
+///         FactorTableD, phi_vector(), S2_easy, AC) and pi(x) for
+///         x = 10^12, 10^13, ... and print the timings as JSON.
+///         All random inputs are generated from --seed, hence
+///         the results of different primecount versions (and
+///         machines) can be compared. Each benchmark reports its
+///         result so that a faster but incorrect version is
+///         detected.
+///
+///         Usage: primecount_bench [--max-x=N] [--x=N]
+///                [--repeat=N] [--seed=N] [--threads=N]
+///                [--filter=NAME]
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <cpu_cache.hpp>
+#include <FactorTableD.hpp>
+#include <generate_primes.hpp>
+#include <gourdon.hpp>
+#include <imath.hpp>
+#include <int128_t.hpp>
+#include <phi_vector.hpp>
+#include <PhiTiny.hpp>
+#include <PiTable.hpp>
+#include <S.hpp>
+#include <Sieve.hpp>
+#include <Vector.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+namespace {
+
+struct Options
+{
+  maxint_t max_x = (maxint_t) 1e14;
+  int64_t x = (int64_t) 1e14;
+  int repeat = 3;
+  uint64_t seed = 42;
+  int threads = 0;
+  std::string filter;
+};
+
+struct Result
+{
+  std::string name;
+  std::string params;
+  std::string result;
+  std::vector<double> secs;
+};
+
+/// Runs the benchmark repeat times, the benchmark
+/// returns its result and its time in seconds.
+///
+template <typename F>
+Result run(const Options& opts,
+           const std::string& name,
+           const std::string& params,
+           F benchmark)
+{
+  Result res;
+  res.name = name;
+  res.params = params;
+
+  for (int i = 0; i < opts.repeat; i++)
+  {
+    std::pair<std::string, double> r = benchmark();
+
+    if (i > 0 && r.first != res.result)
+      throw primecount_error(name + ": results differ between runs");
+
+    res.result = r.first;
+    res.secs.push_back(r.second);
+  }
+
+  std::cerr << name << ": " << res.result << ", "
+            << *std::min_element(res.secs.begin(), res.secs.end())
+            << " sec" << std::endl;
+
+  return res;
+}
+
+/// Times the function, returns its result
+template <typename F>
+std::pair<std::string, double> timed(F f)
+{
+  double time = get_time();
+  maxint_t res = f();
+  return std::make_pair(to_string(res), get_time() - time);
+}
+
+struct Gourdon
+{
+  int64_t y;
+  int64_t z;
+  int64_t k;
+};
+
+/// Same parameters as pi_gourdon(x)
+Gourdon gourdon_params(int64_t x)
+{
+  auto alpha = get_alpha_gourdon(x);
+  int64_t x13 = iroot<3>(x);
+  int64_t sqrtx = isqrt(x);
+  Gourdon g;
+  g.y = (int64_t) (x13 * alpha.first);
+  g.y = std::max(g.y, x13 + 1);
+  g.y = std::min(g.y, sqrtx - 1);
+  g.z = (int64_t) (g.y * alpha.second);
+  g.z = std::max(g.z, g.y);
+  g.z = std::min(g.z, sqrtx - 1);
+  g.k = PhiTiny::get_k(x);
+  return g;
+}
+
+std::string to_json(const Options& opts,
+                    const std::vector<Result>& results)
+{
+  std::ostringstream json;
+  json << std::setprecision(6);
+  json << "{\n";
+  json << "  \"version\": \"" << primecount_version() << "\",\n";
+  json << "  \"threads\": " << opts.threads << ",\n";
+  json << "  \"seed\": " << opts.seed << ",\n";
+  json << "  \"repeat\": " << opts.repeat << ",\n";
+  json << "  \"l1d_cache_size\": " << get_l1d_cache_size() << ",\n";
+  json << "  \"l2_cache_size\": " << get_l2_cache_size() << ",\n";
+  json << "  \"benchmarks\": [";
+
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    const Result& r = results[i];
+    std::vector<double> secs = r.secs;
+    std::sort(secs.begin(), secs.end());
+    double sum = 0;
+    for (double s : secs)
+      sum += s;
+
+    json << (i ? "," : "") << "\n    {";
+    json << "\"name\": \"" << r.name << "\", ";
+    json << "\"params\": {" << r.params << "}, ";
+    json << "\"result\": \"" << r.result << "\", ";
+    json << "\"runs\": " << secs.size() << ", ";
+    json << "\"min_secs\": " << secs.front() << ", ";
+    json << "\"median_secs\": " << secs[secs.size() / 2] << ", ";
+    json << "\"mean_secs\": " << sum / secs.size() << "}";
+  }
+
+  json << "\n  ]\n}\n";
+  return json.str();
+}
+
+void help()
+{
+  std::cout << "Usage: primecount_bench [options]\n"
+               "Benchmark primecount and print the timings as JSON.\n"
+               "\n"
+               "Options:\n"
+               "\n"
+               "  --max-x=N     Benchmark pi(10^12), ... pi(10^k) <= N, default: 1e14\n"
+               "  --x=N         x used for the formula benchmarks, default: 1e14\n"
+               "  --repeat=N    Number of runs of each benchmark, default: 3\n"
+               "  --seed=N      Seed of the random inputs, default: 42\n"
+               "  --threads=N   Number of threads, default: all CPU cores\n"
+               "  --filter=NAME Only run the benchmarks whose name contains NAME\n"
+               "  --help        Print this help menu\n";
+  std::exit(0);
+}
+
+Options parse_options(int argc, char* argv[])
+{
+  Options opts;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    std::size_t pos = arg.find('=');
+    std::string opt = arg.substr(0, pos);
+    std::string val = (pos == std::string::npos) ? "" : arg.substr(pos + 1);
+
+    if (opt == "--help" || opt == "-h")
+      help();
+    else if (val.empty())
+      throw primecount_error("invalid option '" + arg + "'");
+    else if (opt == "--max-x")
+      opts.max_x = to_maxint(val);
+    else if (opt == "--x")
+      opts.x = (int64_t) to_maxint(val);
+    else if (opt == "--repeat")
+      opts.repeat = (int) to_maxint(val);
+    else if (opt == "--seed")
+      opts.seed = (uint64_t) to_maxint(val);
+    else if (opt == "--threads")
+      set_num_threads((int) to_maxint(val));
+    else if (opt == "--filter")
+      opts.filter = val;
+    else
+      throw primecount_error("unrecognized option '" + arg + "'");
+  }
+
+  if (opts.repeat < 1)
+    throw primecount_error("--repeat must be >= 1");
+  if (opts.x < (int64_t) 1e8)
+    throw primecount_error("--x must be >= 10^8");
+
+  opts.threads = get_num_threads();
+  return opts;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  try
+  {
+    Options opts = parse_options(argc, argv);
+    std::vector<Result> results;
+    std::mt19937_64 gen(opts.seed);
+    int threads = opts.threads;
+    int64_t x = opts.x;
+    Gourdon g = gourdon_params(x);
+
+    auto is_enabled = [&](const std::string& name)
+    {
+      return name.find(opts.filter) != std::string::npos;
+    };
+
+    // Sieve a segment of the D formula using
+    // the primes <= 2^16, segment size as in
+    // LoadBalancerS2 (max size).
+    auto primes = generate_primes<uint32_t>(1 << 16);
+    uint64_t c = PhiTiny::max_a();
+    uint64_t segment_size = Sieve::get_segment_size(std::min(get_l1d_cache_size() * 2, get_l2_cache_size()) * 30);
+    uint64_t low = std::uniform_int_distribution<uint64_t>((uint64_t) 1e12, (uint64_t) 1e13)(gen);
+    low -= low % 240;
+    uint64_t high = low + segment_size;
+
+    std::ostringstream sieve_params;
+    sieve_params << "\"low\": " << low << ", \"segment_size\": " << segment_size
+                 << ", \"primes\": " << primes.size() - 1;
+
+    if (is_enabled("Sieve::cross_off_count"))
+      results.push_back(run(opts, "Sieve::cross_off_count", sieve_params.str(), [&]
+      {
+        return timed([&]
+        {
+          uint64_t sum = 0;
+          for (int i = 0; i < 10; i++)
+          {
+            Sieve sieve(low, segment_size, primes.size());
+            sieve.pre_sieve(primes, c, low, high);
+            for (uint64_t b = c + 1; b < primes.size(); b++)
+              sieve.cross_off_count(primes[b], b);
+            sum += sieve.get_total_count();
+          }
+          return (maxint_t) sum;
+        });
+      }));
+
+    if (is_enabled("Sieve::count"))
+    {
+      // Ascending stops as in the D formula
+      std::vector<uint64_t> stops(1 << 20);
+      std::uniform_int_distribution<uint64_t> dist(0, segment_size - 1);
+      for (uint64_t& stop : stops)
+        stop = dist(gen);
+      for (std::size_t i = 0; i < stops.size(); i += 1 << 10)
+        std::sort(stops.begin() + i, stops.begin() + i + (1 << 10));
+
+      Sieve sieve(low, segment_size, primes.size());
+      sieve.pre_sieve(primes, c, low, high);
+      for (uint64_t b = c + 1; b < primes.size() / 2; b++)
+        sieve.cross_off_count(primes[b], b);
+
+      results.push_back(run(opts, "Sieve::count", sieve_params.str() + ", \"queries\": " + std::to_string(stops.size()), [&]
+      {
+        return timed([&]
+        {
+          uint64_t sum = 0;
+          for (std::size_t i = 0; i < stops.size(); i++)
+          {
+            if (i % (1 << 10) == 0)
+              sieve.reset_counter();
+            sum += sieve.count(stops[i]);
+          }
+          return (maxint_t) sum;
+        });
+      }));
+    }
+
+    std::string yz_params = "\"x\": " + std::to_string(x) + ", \"y\": " + std::to_string(g.y) + ", \"z\": " + std::to_string(g.z);
+
+    if (is_enabled("PiTable"))
+    {
+      int64_t limit = isqrt(x) * 10;
+      results.push_back(run(opts, "PiTable", "\"limit\": " + std::to_string(limit), [&]
+      {
+        return timed([&]
+        {
+          PiTable pi(limit, threads);
+          return (maxint_t) pi[limit];
+        });
+      }));
+    }
+
+    if (is_enabled("FactorTableD"))
+      results.push_back(run(opts, "FactorTableD", yz_params, [&]
+      {
+        return timed([&]
+        {
+          FactorTableD<uint32_t> factor(g.y, g.z, threads);
+          int64_t leaves = 0;
+          for (int64_t i = factor.to_index(g.z); i > 0; i--)
+            leaves += (factor.is_leaf(i) != 0);
+          return (maxint_t) leaves;
+        });
+      }));
+
+    if (is_enabled("phi_vector"))
+    {
+      // phi_vector() is called at the start of each
+      // chunk of the D formula.
+      PiTable pi(g.y, threads);
+      auto primes_y = generate_primes<uint32_t>(g.y);
+      int64_t x_star = get_x_star_gourdon(x, g.y);
+      std::vector<int64_t> lows(1000);
+      std::uniform_int_distribution<int64_t> dist(1, g.z);
+      for (int64_t& l : lows)
+        l = dist(gen);
+
+      results.push_back(run(opts, "phi_vector", yz_params + ", \"calls\": " + std::to_string(lows.size()), [&]
+      {
+        return timed([&]
+        {
+          int64_t sum = 0;
+          for (int64_t l : lows)
+          {
+            int64_t max_b = pi[std::min({ isqrt(x / l), isqrt(g.z), x_star })];
+            Vector<int64_t> phi = phi_vector(l, max_b, primes_y, pi);
+            sum += phi[max_b];
+          }
+          return (maxint_t) sum;
+        });
+      }));
+    }
+
+    if (is_enabled("S2_easy"))
+    {
+      double alpha = get_alpha_deleglise_rivat(x);
+      int64_t y = (int64_t) (iroot<3>(x) * alpha);
+      int64_t z = x / y;
+      int64_t c2 = PhiTiny::get_c(y);
+      std::string params = "\"x\": " + std::to_string(x) + ", \"y\": " + std::to_string(y) + ", \"z\": " + std::to_string(z);
+
+      results.push_back(run(opts, "S2_easy", params, [&]
+      {
+        return timed([&] { return (maxint_t) S2_easy(x, y, z, c2, threads, false); });
+      }));
+    }
+
+    if (is_enabled("AC"))
+      results.push_back(run(opts, "AC", yz_params, [&]
+      {
+        return timed([&] { return (maxint_t) AC(x, g.y, g.z, g.k, threads, false); });
+      }));
+
+    for (maxint_t n = (maxint_t) 1e12; n <= opts.max_x; n *= 10)
+    {
+      std::string name = "pi(10^" + std::to_string((int) std::round(std::log10((double) n))) + ")";
+
+      if (is_enabled(name))
+        results.push_back(run(opts, name, "\"x\": \"" + to_string(n) + "\"", [&]
+        {
+          return timed([&] { return pi(n, threads); });
+        }));
+    }
+
+    std::cout << to_json(opts, results);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "primecount_bench: " << e.what() << std::endl
+              << "Try 'primecount_bench --help' for more information." << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
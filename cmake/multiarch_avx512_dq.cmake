@@ -0,0 +1,64 @@
+# We use GCC/Clang's function multi-versioning for AVX512
+# support. The D formula computes its x / (prime * m)
+# divisions using AVX512 double precision division if the
+# CPU supports AVX512DQ and uses the default (portable)
+# integer division otherwise.
+
+include(CheckCXXSourceCompiles)
+include(CMakePushCheckState)
+
+cmake_push_check_state()
+set(CMAKE_REQUIRED_INCLUDES "${PROJECT_SOURCE_DIR}")
+
+check_cxx_source_compiles("
+    // GCC/Clang function multiversioning for AVX512 is not needed if
+    // the user compiles with -mavx512f -mavx512dq.
+    // GCC/Clang function multiversioning generally causes a minor
+    // overhead, hence we disable it if it is not needed.
+    #if defined(__AVX512F__) && \
+        defined(__AVX512DQ__)
+      Error: AVX512 multiarch not needed!
+    #endif
+
+    #include <src/x86/cpuid.cpp>
+    #include <immintrin.h>
+    #include <stdint.h>
+
+    void div_default(uint64_t x, const uint64_t* d, uint64_t* q)
+    {
+        for (int i = 0; i < 8; i++)
+            q[i] = x / d[i];
+    }
+
+    __attribute__ ((target (\"avx512f,avx512dq\")))
+    void div_avx512(uint64_t x, const uint64_t* d, uint64_t* q)
+    {
+        __m512i vd = _mm512_loadu_si512((const void*) d);
+        __m512d vx = _mm512_set1_pd((double) x);
+        __m512d vq = _mm512_div_pd(vx, _mm512_cvtepu64_pd(vd));
+        __m512i vq64 = _mm512_cvttpd_epu64(vq);
+        __m512i vr = _mm512_sub_epi64(_mm512_set1_epi64(x), _mm512_mullo_epi64(vq64, vd));
+        __mmask8 mask = _mm512_cmplt_epi64_mask(vr, _mm512_setzero_si512());
+        vq64 = _mm512_mask_sub_epi64(vq64, mask, vq64, _mm512_set1_epi64(1));
+        _mm512_storeu_si512((void*) q, vq64);
+    }
+
+    int main()
+    {
+        uint64_t d[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        uint64_t q[8];
+
+        if (primecount::has_cpuid_avx512_dq())
+            div_avx512(100, d, q);
+        else
+            div_default(100, d, q);
+
+        return (q[0] == 100) ? 0 : 1;
+    }
+" multiarch_avx512_dq)
+
+if(multiarch_avx512_dq)
+    list(APPEND PRIMECOUNT_COMPILE_DEFINITIONS "ENABLE_MULTIARCH_AVX512_DQ")
+endif()
+
+cmake_pop_check_state()
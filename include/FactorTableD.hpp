@@ -6,9 +6,10 @@
 ///        table which furthermore only contains entries for numbers
 ///        which are not divisible by 2, 3, 5, 7 and 11. The factor[n]
 ///        lookup table uses up to 28 times less memory than the
-///        lpf[n], mpf[n] and mu[n] lookup tables! factor[n] uses only
-///        2 bytes per entry for 32-bit numbers and 4 bytes per entry
-///        for 64-bit numbers.
+///        lpf[n], mpf[n] and mu[n] lookup tables! Instead of the
+///        least prime factor we store its index pi(lpf), hence
+///        factor[n] uses only 2 bytes per entry for all
+///        z <= 1.47 * 10^11 and 4 bytes per entry for larger z.
 ///
 ///        The factor table concept was devised and implemented by
 ///        Christian Bau in 2003. Note that Tomás Oliveira e Silva
@@ -24,18 +25,18 @@
 ///        2) INT_MAX      if n is a prime
 ///        3) 0            if n has a prime factor > y
 ///        4) 0            if moebius(n) = 0
-///        5) lpf - 1      if moebius(n) = 1
-///        6) lpf          if moebius(n) = -1
+///        5) 2 * pi(lpf)      if moebius(n) = 1
+///        6) 2 * pi(lpf) + 1  if moebius(n) = -1
 ///
 ///        factor[1] = (INT_MAX - 1) because 1 contributes to the
 ///        sum of the ordinary leaves S1(x, a) in the
 ///        Lagarias-Miller-Odlyzko and Deleglise-Rivat algorithms.
 ///        The values above allow to replace the 1st if statement
 ///        below used in the D(x, y) formula by the 2nd new if
-///        statement which is obviously faster.
+///        statement which is obviously faster (prime = primes[b]).
 ///
 ///        * Old: if (mu[n] != 0 && lpf[n] > prime && mpf[n] <= y)
-///        * New: if (prime < factor[n])
+///        * New: if (2 * b + 1 < factor[n])
 ///
 /// Copyright (C) 2023 Kim Walisch, <kim.walisch@gmail.com>
 ///
@@ -56,6 +57,7 @@
 #include <Vector.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <stdint.h>
 
 namespace {
@@ -70,47 +72,73 @@ public:
   FactorTableD(int64_t y,
                int64_t z,
                int threads)
+    : FactorTableD(y, z, 1, z, threads)
+  { }
+
+  /// Segmented FactorTableD: factor only the numbers
+  /// inside [low, high] with high <= z. Used to reduce the
+  /// memory usage of the D formula, the D formula is then
+  /// computed once for each segment [low, high] of [1, z]
+  /// (see get_factor_table_segments()). Requires
+  /// low % 2310 = 1 so that the segments don't overlap.
+  ///
+  FactorTableD(int64_t y,
+               int64_t z,
+               int64_t low,
+               int64_t high,
+               int threads)
   {
     if_unlikely(z > max())
       throw primecount_error("z must be <= FactorTable::max()");
 
     z = std::max<int64_t>(1, z);
+    low = std::max<int64_t>(1, low);
+    high = std::max(low, std::min(high, z));
+    ASSERT(low % coprime_indexes_.size() == 1);
+
     T T_MAX = pstd::numeric_limits<T>::max();
-    factor_.resize(to_index(z) + 1);
+    low_ = low;
+    high_ = high;
+    offset_ = to_index(low);
+    factor_.resize(to_index(high) + 1 - offset_);
 
     // mu(1) = 1.
     // 1 has zero prime factors, hence 1 has an even
     // number of prime factors. We use the least
     // significant bit to indicate whether the number
     // has an even or odd number of prime factors.
-    factor_[0] = T_MAX ^ 1;
+    if (low == 1)
+      factor_[0] = T_MAX ^ 1;
 
-    int64_t sqrtz = isqrt(z);
+    int64_t sqrt_high = isqrt(high);
+    int64_t dist = high - (low - 1);
     int64_t thread_threshold = (int64_t) 1e7;
-    threads = ideal_num_threads(z, threads, thread_threshold);
-    int64_t thread_distance = ceil_div(z, threads);
+    threads = ideal_num_threads(dist, threads, thread_threshold);
+    int64_t thread_distance = ceil_div(dist, threads);
     thread_distance += coprime_indexes_.size() - thread_distance % coprime_indexes_.size();
 
     #pragma omp parallel for num_threads(threads)
     for (int t = 0; t < threads; t++)
     {
       // Thread processes interval [low, high]
-      int64_t low = thread_distance * t;
+      int64_t low = (low_ - 1) + thread_distance * t;
       int64_t high = low + thread_distance;
       low = std::max(first_coprime(), low + 1);
-      high = std::min(high, z);
+      high = std::min(high, high_);
 
       if (low <= high)
       {
         // Default initialize memory to all bits set
         int64_t low_idx = to_index(low);
         int64_t size = (to_index(high) + 1) - low_idx;
-        std::fill_n(&factor_[low_idx], size, T_MAX);
+        std::fill_n(&factor_[low_idx - offset_], size, T_MAX);
 
         int64_t start = first_coprime();
         int64_t stop = high / first_coprime();
         int64_t min_m = first_coprime() * first_coprime();
         primesieve::iterator it(start, stop);
+        // pi(first_coprime() - 1) = pi(12) = 5
+        int64_t b = 5;
 
         if (min_m <= high)
         {
@@ -121,16 +149,26 @@ public:
             int64_t prime = it.next_prime();
             int64_t multiple = next_multiple(prime, low, &i);
             min_m = prime * first_coprime();
+            b++;
 
             if (min_m > high)
               break;
 
+            // The least significant bit is set as the
+            // prime has 1 prime factor.
+            T lpf = (T) (2 * b + 1);
+
             for (; multiple <= high; multiple = prime * to_number(i++))
             {
-              int64_t mi = to_index(multiple);
-              // prime is the smallest factor of multiple
+              int64_t mi = to_index(multiple) - offset_;
+              // prime is the smallest factor of multiple,
+              // hence prime <= sqrt(high) and lpf fits into T.
               if (factor_[mi] == T_MAX)
-                factor_[mi] = (T) prime;
+              {
+                ASSERT(prime <= sqrt_high);
+                ASSERT(2 * b + 1 < T_MAX - 1);
+                factor_[mi] = lpf;
+              }
               // the least significant bit indicates
               // whether multiple has an even (0) or odd (1)
               // number of prime factors
@@ -138,7 +176,7 @@ public:
                 factor_[mi] ^= 1;
             }
 
-            if (prime <= sqrtz)
+            if (prime <= sqrt_high)
             {
               int64_t j = 0;
               int64_t square = prime * prime;
@@ -147,7 +185,7 @@ public:
               // Sieve out numbers that are not square free
               // i.e. numbers for which moebius(n) = 0.
               for (; multiple <= high; multiple = square * to_number(j++))
-                factor_[to_index(multiple)] = 0;
+                factor_[to_index(multiple) - offset_] = 0;
             }
           }
         }
@@ -172,29 +210,50 @@ public:
             // Sieve out primes > y &&
             // Sieve out numbers with prime factors > y
             for (; next <= high; next = prime * to_number(i++))
-              factor_[to_index(next)] = 0;
+              factor_[to_index(next) - offset_] = 0;
           }
         }
       }
     }
   }
 
-  /// Returns true if n (with n = to_number(index)) is a
-  /// hard special leaf in the D formula of Xavier
-  /// Gourdon's prime counting algorithm.
+  /// Copy the lookup table, used to replicate
+  /// the FactorTableD on each NUMA node (--numa).
+  ///
+  explicit FactorTableD(const FactorTableD& other)
+    : low_(other.low_),
+      high_(other.high_),
+      offset_(other.offset_)
+  {
+    factor_.resize(other.factor_.size());
+    std::copy_n(other.factor_.data(), other.factor_.size(), factor_.data());
+  }
+
+  /// n (with n = to_number(index)) is a hard special leaf
+  /// of primes[b] in the D formula of Xavier Gourdon's
+  /// prime counting algorithm if:
+  /// is_leaf(index) > leaf_bound(b).
   ///
   /// Return value:
   ///
-  /// 1) INT_MAX - 1  if n = 1
-  /// 2) INT_MAX      if n is a prime
-  /// 3) 0            if n has a prime factor > y
-  /// 4) 0            if moebius(n) = 0
-  /// 5) lpf - 1      if moebius(n) = 1
-  /// 6) lpf          if moebius(n) = -1
+  /// 1) INT_MAX - 1      if n = 1
+  /// 2) INT_MAX          if n is a prime
+  /// 3) 0                if n has a prime factor > y
+  /// 4) 0                if moebius(n) = 0
+  /// 5) 2 * pi(lpf)      if moebius(n) = 1
+  /// 6) 2 * pi(lpf) + 1  if moebius(n) = -1
   ///
   int64_t is_leaf(int64_t index) const
   {
-    return factor_[index];
+    return factor_[index - offset_];
+  }
+
+  /// is_leaf(index) > 2 * b + 1 if and only if
+  /// lpf(n) > primes[b] (and mu(n) != 0 and mpf(n) <= y).
+  ///
+  static int64_t leaf_bound(int64_t b)
+  {
+    return 2 * b + 1;
   }
 
   /// Get the Möbius function value of the number
@@ -209,6 +268,8 @@ public:
   {
     // mu(n) = 0 is disabled by default for performance
     // reasons, we only enable it for testing.
+    index -= offset_;
+
     #if defined(ENABLE_MU_0_TESTING)
       if (factor_[index] == 0)
         return 0;
@@ -222,13 +283,52 @@ public:
       return 1;
   }
 
+  /// The numbers inside [low(), high()]
+  /// have been factored.
+  ///
+  int64_t low() const
+  {
+    return low_;
+  }
+
+  int64_t high() const
+  {
+    return high_;
+  }
+
+  /// Index of low()
+  int64_t first_index() const
+  {
+    return offset_;
+  }
+
+  /// Index of high()
+  int64_t last_index() const
+  {
+    return offset_ + (int64_t) factor_.size() - 1;
+  }
+
+  /// The index of the least prime factor (and b) must be
+  /// <= (T_MAX - 3) / 2, hence we require z < p^2 with
+  /// p = nth_prime((T_MAX - 3) / 2 + 1). We use Dusart's
+  /// lower bound: nth_prime(n) >= n * (log(n) + log(log(n)) - 1).
+  ///
   static maxint_t max()
   {
-    maxint_t T_MAX = pstd::numeric_limits<T>::max();
-    return ipow<2>(T_MAX - 1) - 1;
+    double n = (double) ((pstd::numeric_limits<T>::max() - 3) / 2 + 1);
+    double p = n * (std::log(n) + std::log(std::log(n)) - 1);
+    double max_z = p * p;
+
+    if (max_z >= (double) pstd::numeric_limits<maxint_t>::max())
+      return pstd::numeric_limits<maxint_t>::max();
+    else
+      return (maxint_t) max_z - 1;
   }
 
 private:
+  int64_t low_ = 1;
+  int64_t high_ = 1;
+  int64_t offset_ = 0;
   Vector<T> factor_;
 };
 
@@ -16,8 +16,13 @@
 #ifndef LOADBALANCERAC_HPP
 #define LOADBALANCERAC_HPP
 
+#include <distributed.hpp>
+#include <int128_t.hpp>
 #include <OmpLock.hpp>
+#include <progress.hpp>
+
 #include <stdint.h>
+#include <string>
 
 namespace primecount {
 
@@ -26,20 +31,48 @@ struct ThreadDataAC
   int64_t low = 0;
   int64_t segments = 0;
   int64_t segment_size = 0;
+  maxint_t sum = 0;
   double secs = 0;
+
+  // Totals of all chunks processed by this thread
+  int64_t total_chunks = 0;
+  int64_t total_segments = 0;
+  double total_secs = 0;
+
+  // Used by --trace=FILE
+  int id = -1;
+  double assigned_time = 0;
+  double wait_secs = 0;
+
+  // Used by the worker processes, the coordinator
+  // counts each worker thread once.
+  bool is_registered = false;
 };
 
 class LoadBalancerAC
 {
 public:
-  LoadBalancerAC(int64_t sqrtx, int64_t y, int threads, bool is_print);
+  LoadBalancerAC(maxint_t x, int64_t sqrtx, int64_t y, int64_t z, int64_t k, int threads, bool is_print);
+  void set_interval(int64_t low, int64_t high);
+  void serve_workers();
   bool get_work(ThreadDataAC& thread);
+  maxint_t get_sum() const;
 
 private:
+  bool assign_work(ThreadDataAC& thread, double time);
+  bool get_remote_work(ThreadDataAC& thread);
+  std::string reply_worker(const std::string& request);
+  bool is_finished() const;
   void print_status(double current_time);
+  void trace(ThreadDataAC& thread, double lock_time);
+  maxint_t x_ = 0;
+  maxint_t sum_ = 0;
+  int64_t start_ = 0;
   int64_t low_ = 0;
   int64_t sqrtx_ = 0;
   int64_t y_ = 0;
+  int64_t z_ = 0;
+  int64_t k_ = 0;
   int64_t segments_ = 0;
   int64_t segment_size_ = 0;
   int64_t segment_nr_ = 0;
@@ -47,7 +80,16 @@ private:
   double start_time_ = 0;
   double print_time_ = 0;
   int threads_ = 0;
+  int thread_ids_ = 0;
   bool is_print_ = false;
+  bool is_worker_ = false;
+  bool is_coordinator_ = false;
+  bool is_nested_ = false;
+  // Nested pi(x) computations are not traced
+  bool is_trace_ = false;
+  std::string error_;
+  Progress* progress_ = nullptr;
+  RemoteChunks remote_;
   OmpLock lock_;
 };
 
@@ -15,6 +15,7 @@
 
 #include <int128_t.hpp>
 #include <OmpLock.hpp>
+#include <progress.hpp>
 
 #include <stdint.h>
 
@@ -23,9 +24,10 @@ namespace primecount {
 class LoadBalancerP2
 {
 public:
-  LoadBalancerP2(maxint_t x, int64_t sieve_limit, int threads, bool is_print);
+  LoadBalancerP2(maxint_t x, int64_t low, int64_t sieve_limit, int threads, bool is_print);
   bool get_work(int64_t& low, int64_t& high);
   int get_threads() const;
+  void check_cancelled() const;
 
 private:
   void print_status();
@@ -38,6 +40,7 @@ private:
   int threads_ = 0;
   int precision_ = 0;
   bool is_print_ = false;
+  Progress* progress_ = nullptr;
   OmpLock lock_;
 };
 
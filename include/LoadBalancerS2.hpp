@@ -1,7 +1,7 @@
 ///
 /// @file  LoadBalancerS2.hpp
 ///
-/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
 /// file in the top level directory.
@@ -11,12 +11,17 @@
 #define LOADBALANCERS2_HPP
 
 #include <primecount-internal.hpp>
+#include <distributed.hpp>
 #include <int128_t.hpp>
 #include <macros.hpp>
 #include <OmpLock.hpp>
+#include <progress.hpp>
 #include <StatusS2.hpp>
+#include <Vector.hpp>
 
 #include <stdint.h>
+#include <atomic>
+#include <string>
 
 namespace primecount {
 
@@ -26,9 +31,23 @@ struct ThreadData
   int64_t segments = 0;
   int64_t segment_size = 0;
   maxint_t sum = 0;
+  // Sum of the previous chunks that has not yet been
+  // added to the load balancer's sum (lock-free mode)
+  maxint_t pending_sum = 0;
   double init_secs = 0;
   double secs = 0;
 
+  // Totals of all chunks processed by this thread
+  int64_t total_chunks = 0;
+  int64_t total_segments = 0;
+  double total_init_secs = 0;
+  double total_secs = 0;
+
+  // Used by --trace=FILE
+  int id = -1;
+  double assigned_time = 0;
+  double wait_secs = 0;
+
   void start_time()
   {
     secs = get_time();
@@ -55,27 +74,77 @@ class LoadBalancerS2
 {
 public:
   LoadBalancerS2(maxint_t x, int64_t sieve_limit, maxint_t sum_approx, int threads, bool is_print);
+  void set_interval(int64_t low, int64_t high);
+  void set_pass(int64_t pass, int64_t passes);
+  void set_formula(const std::string& formula, int64_t y, int64_t z, int64_t k);
+  void serve_workers();
   bool get_work(ThreadData& thread);
   maxint_t get_sum() const;
 
 private:
+  /// Interval [low, low + segments * segment_size[
+  struct Chunk
+  {
+    int64_t low;
+    int64_t segments;
+    int64_t segment_size;
+  };
+
+  bool get_work_locked(ThreadData& thread);
+  bool get_work_lock_free(ThreadData& thread);
+  void print_status(const ThreadData& thread);
+  bool get_remote_work(ThreadData& thread);
+  std::string reply_worker(const std::string& request);
+  bool is_finished() const;
+  std::string interval() const;
+  bool get_resumed_work(ThreadData& thread);
+  bool get_expired_work(ThreadData& thread);
+  void finish_chunk(const ThreadData& thread);
+  void thread_finished(const ThreadData& thread);
+  bool is_cancelled() const;
+  void trace(ThreadData& thread, double lock_time);
+  void backup();
   void update_load_balancing(const ThreadData& thread);
   void update_number_of_segments(const ThreadData& thread);
   void update_segment_size();
   double remaining_secs() const;
 
-  int64_t low_ = 0;
+  maxint_t x_ = 0;
+  int64_t y_ = 0;
+  int64_t z_ = 0;
+  int64_t k_ = 0;
+  int64_t start_ = 0;
   int64_t max_low_ = 0;
   int64_t sieve_limit_ = 0;
-  int64_t segments_ = 0;
-  int64_t segment_size_ = 0;
   int64_t max_size_ = 0;
+  int threads_ = 0;
   maxint_t sum_ = 0;
   maxint_t sum_approx_ = 0;
   double time_ = 0;
+  double backup_time_ = 0;
   bool is_print_ = false;
+  bool is_backup_ = false;
+  bool is_backup_finished_ = false;
+  bool is_worker_ = false;
+  bool is_coordinator_ = false;
+  bool is_nested_ = false;
+  // Nested pi(x) computations are not traced
+  bool is_trace_ = false;
+  std::string formula_;
+  std::string error_;
+  Progress* progress_ = nullptr;
+  Vector<Chunk> unfinished_;
+  Vector<Chunk> resumed_;
+  RemoteChunks remote_;
   StatusS2 status_;
   OmpLock lock_;
+  // The next chunk is [low_, low_ + segments_ * segment_size_[.
+  // Only the thread holding the lock modifies segments_ and
+  // segment_size_, low_ is also advanced without locking.
+  MAYBE_UNUSED char pad_[MAX_CACHE_LINE_SIZE];
+  std::atomic<int64_t> low_{0};
+  std::atomic<int64_t> segments_{0};
+  std::atomic<int64_t> segment_size_{0};
 };
 
 } // namespace
@@ -1,9 +1,9 @@
 ///
 /// @file   OmpLock.hpp
-/// @brief  The OmpLock and LockGuard classes are RAII-style
-///         wrappers for OpenMP locks.
+/// @brief  The OmpLock, LockGuard and TryLockGuard classes are
+///         RAII-style wrappers for OpenMP locks.
 ///
-/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
 /// file in the top level directory.
@@ -29,6 +29,7 @@ inline void omp_init_lock(omp_lock_t*) { }
 inline void omp_destroy_lock(omp_lock_t*) { }
 inline void omp_set_lock(omp_lock_t*) { }
 inline void omp_unset_lock(omp_lock_t*) { }
+inline int omp_test_lock(omp_lock_t*) { return 1; }
 
 } // namespace
 
@@ -93,6 +94,41 @@ private:
   omp_lock_t* lock_ = nullptr;
 };
 
+/// Acquires the lock only if it is not
+/// held by another thread (non-blocking).
+///
+class TryLockGuard
+{
+public:
+  TryLockGuard(OmpLock& lock)
+  {
+    ASSERT(lock.is_initialized());
+
+    if (lock.threads_ <= 1)
+      is_locked_ = true;
+    else if (omp_test_lock(&lock.lock_))
+    {
+      lock_ = &lock.lock_;
+      is_locked_ = true;
+    }
+  }
+
+  ~TryLockGuard()
+  {
+    if (lock_)
+      omp_unset_lock(lock_);
+  }
+
+  bool owns_lock() const
+  {
+    return is_locked_;
+  }
+
+private:
+  omp_lock_t* lock_ = nullptr;
+  bool is_locked_ = false;
+};
+
 } // namespace
 
 #endif
@@ -30,6 +30,7 @@ class PiTable : public BitSieve240
 {
 public:
   PiTable(uint64_t max_x, int threads);
+  explicit PiTable(const PiTable& other);
 
   uint64_t size() const
   {
@@ -82,6 +82,11 @@ public:
     return total_count_;
   }
 
+  /// Restart counting from the beginning of the
+  /// current segment, after this count(stop) may be
+  /// called with a stop number < the previous one.
+  void reset_counter();
+
   template <typename T>
   void pre_sieve(const Vector<T>& primes, uint64_t c, uint64_t low, uint64_t high)
   {
@@ -284,12 +289,22 @@ private:
     return svaddv_u64(svptrue_b64(), vcnt);
   }
 
+#endif
+
+  void cross_off_count_pattern_default(uint64_t prime, uint64_t i);
+
+#if defined(ENABLE_AVX512_VPOPCNT) || \
+    defined(ENABLE_MULTIARCH_AVX512_VPOPCNT)
+  #if defined(ENABLE_MULTIARCH_AVX512_VPOPCNT)
+    __attribute__ ((target ("avx512f,avx512vpopcntdq")))
+  #endif
+  void cross_off_count_pattern_avx512(uint64_t prime, uint64_t i);
 #endif
 
   void add(uint64_t prime);
+  void update_wheel(uint64_t prime, uint64_t i);
   void allocate_counter(uint64_t low);
   void init_counter(uint64_t low, uint64_t high);
-  void reset_counter();
   void reset_sieve(uint64_t low, uint64_t high);
   uint64_t segment_size() const;
   static const Array<uint64_t, 240> unset_smaller;
@@ -328,6 +343,7 @@ private:
   };
 
   uint64_t start_ = 0;
+  uint64_t low_ = 0;
   uint64_t prev_stop_ = 0;
   uint64_t count_ = 0;
   uint64_t total_count_ = 0;
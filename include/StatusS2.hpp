@@ -21,6 +21,8 @@ public:
   void print(int64_t b, int64_t max_b);
   void print(int64_t low, int64_t limit, maxint_t sum, maxint_t sum_approx);
   static double getPercent(int64_t low, int64_t limit, maxint_t sum, maxint_t sum_approx);
+  double getTotalPercent(int64_t low, int64_t limit, maxint_t sum, maxint_t sum_approx) const;
+  void setPass(int64_t pass, int64_t passes);
 private:
   void print(double percent);
   double epsilon_ = 0;
@@ -30,6 +32,8 @@ private:
   // since last printing the status.
   double threshold_ = 0.1;
   int precision_ = 0;
+  int64_t pass_ = 0;
+  int64_t passes_ = 1;
 };
 
 } // namespace
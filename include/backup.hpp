@@ -0,0 +1,41 @@
+///
+/// @file  backup.hpp
+/// @brief Computations of pi(x) with x >= 10^25 take days or even
+///        weeks. In order to prevent losing all intermediate results
+///        if the computer crashes (or is rebooted) we periodically
+///        store the state of the long running formulas in a backup
+///        file. The backup file is a plain text file which contains
+///        one "key = value" pair per line.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef BACKUP_HPP
+#define BACKUP_HPP
+
+#include <int128_t.hpp>
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+namespace primecount {
+
+using Backup = std::map<std::string, std::string>;
+
+void set_backup_file(const std::string& filename);
+const std::string& backup_file();
+bool is_backup();
+
+Backup load_backup();
+void store_backup(const Backup& backup);
+
+bool is_resume(const Backup& backup, const std::string& formula, maxint_t x, int64_t y, int64_t z, int64_t k);
+void reset_backup(Backup& backup, const std::string& formula, maxint_t x, int64_t y, int64_t z, int64_t k);
+
+} // namespace
+
+#endif
@@ -0,0 +1,33 @@
+///
+/// @file  cpu_cache.hpp
+/// @brief Per CPU core L1 data cache and L2 cache sizes used
+///        by the load balancers. The cache sizes are detected
+///        at runtime, if detection fails we fall back to the
+///        L1D_CACHE_SIZE and L2_CACHE_SIZE defaults from
+///        primecount-config.hpp. The cache sizes can be
+///        overridden (--L1d-cache=BYTES, --L2-cache=BYTES)
+///        e.g. for benchmarking.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef CPU_CACHE_HPP
+#define CPU_CACHE_HPP
+
+#include <stdint.h>
+
+namespace primecount {
+
+int64_t get_l1d_cache_size();
+int64_t get_l2_cache_size();
+
+/// @bytes: 0 = use the detected cache size
+void set_l1d_cache_size(int64_t bytes);
+void set_l2_cache_size(int64_t bytes);
+
+} // namespace
+
+#endif
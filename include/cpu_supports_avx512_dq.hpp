@@ -0,0 +1,27 @@
+///
+/// @file  cpu_supports_avx512_dq.hpp
+/// @brief Detect if the x86 CPU supports AVX512F and AVX512DQ.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef CPU_SUPPORTS_AVX512_DQ_HPP
+#define CPU_SUPPORTS_AVX512_DQ_HPP
+
+namespace primecount {
+
+bool has_cpuid_avx512_dq();
+
+} // namespace
+
+namespace {
+
+/// Initialized at startup
+const bool cpu_supports_avx512_dq = primecount::has_cpuid_avx512_dq();
+
+} // namespace
+
+#endif
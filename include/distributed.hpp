@@ -0,0 +1,111 @@
+///
+/// @file  distributed.hpp
+/// @brief Distributed computing of the A + C, D and S2_hard
+///        formulas. The coordinator process assigns work to the
+///        worker processes (which may run on different hosts). The
+///        workers connect to the coordinator using TCP, each request
+///        and each reply is a single line of text.
+///
+///        Worker:      primecount 1e24 --D --worker=host:5000
+///        Coordinator: primecount 1e24 --D --coordinator=5000
+///
+///        Alternatively the sieving interval of the A + C, B and D
+///        formulas can be split into chunks manually. Each chunk is
+///        computed by a separate process and the partial sums of all
+///        chunks add up to the result of the formula.
+///
+///        primecount 1e24 --D --low=0 --high=1e11
+///        primecount 1e24 --D --low=1e11 --high=1e18
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef DISTRIBUTED_HPP
+#define DISTRIBUTED_HPP
+
+#include <Vector.hpp>
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+namespace primecount {
+
+void set_chunk(int64_t low, int64_t high);
+bool is_chunk();
+
+/// Restrict the sieving interval [low, high[
+/// to the chunk set using set_chunk().
+///
+void restrict_to_chunk(int64_t& low, int64_t& high);
+
+void set_coordinator(const std::string& port);
+void set_worker(const std::string& coordinator);
+bool is_coordinator();
+bool is_worker();
+
+/// @connect_secs: a worker gives up if it cannot connect to the
+///                coordinator within connect_secs (default 1 hour,
+///                as pi(x) first computes the other formulas).
+/// @io_secs:      max time to send or receive a line (default 30).
+/// @chunk_secs:   a chunk that has not been finished after
+///                max(chunk_secs, 4 * slowest chunk) seconds is
+///                reassigned to another worker (default 600).
+///
+void set_distributed_timeouts(double connect_secs,
+                              double io_secs,
+                              double chunk_secs);
+
+/// Used by the workers: send the request to
+/// the coordinator and return its reply.
+///
+std::string send_request(const std::string& request);
+
+/// Used by the coordinator: reply to the requests of the
+/// workers until is_finished() returns true.
+///
+void serve_requests(const std::function<std::string(const std::string&)>& reply,
+                    const std::function<bool()>& is_finished);
+
+/// The chunks that the coordinator has assigned to the worker
+/// processes. If a worker dies (or hangs) its chunk is not
+/// finished before the chunk's deadline, the chunk then
+/// expires and is reassigned to another worker. Whichever
+/// worker reports an expired chunk first has its sum counted.
+///
+class RemoteChunks
+{
+public:
+  /// Interval [low, low + segments * segment_size[
+  struct Chunk
+  {
+    int64_t low;
+    int64_t segments;
+    int64_t segment_size;
+  };
+
+  void assign(const Chunk& chunk);
+  /// Returns false if the chunk has already been
+  /// finished by another worker.
+  bool finish(int64_t low, double secs);
+  bool get_expired(Chunk& chunk);
+  bool empty() const;
+
+private:
+  struct Assigned
+  {
+    Chunk chunk;
+    double deadline;
+  };
+
+  Vector<Assigned> assigned_;
+  Vector<Chunk> expired_;
+  double max_secs_ = 0;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,233 @@
+///
+/// @file  fast_div_batch.hpp
+/// @brief Compute many integer divisions x / d[i] with the same
+///        dividend x using SIMD double precision division. On
+///        x86 CPUs with AVX512DQ the 8 divisions of a vector
+///        (vdivpd) are computed about twice as fast as 8 scalar
+///        64-bit integer divisions (divq).
+///
+///        The double precision quotient is truncated and then
+///        corrected by +/- 1 using exact integer arithmetic,
+///        hence the result is always identical to integer
+///        division. This requires x / d[i] < 2^50, so that the
+///        rounding error of the double precision quotient is
+///        < 1/4.
+///
+///        Note that libdivide is of no use here: its branchfree
+///        divider must be computed once per divisor, but in D(x, y)
+///        the divisor changes for every single division.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef FAST_DIV_BATCH_HPP
+#define FAST_DIV_BATCH_HPP
+
+#include <fast_div.hpp>
+#include <macros.hpp>
+
+#include <stdint.h>
+
+#if defined(__AVX512F__) && \
+    defined(__AVX512DQ__) && \
+    __has_include(<immintrin.h>)
+  #include <immintrin.h>
+  #define ENABLE_AVX512_DIV_BATCH
+
+#elif defined(ENABLE_MULTIARCH_AVX512_DQ)
+  #include <cpu_supports_avx512_dq.hpp>
+  #include <immintrin.h>
+#endif
+
+namespace {
+
+/// Number of divisions per batch
+constexpr int DIV_BATCH_SIZE = 64;
+
+/// Quotients >= 2^50 are not supported
+constexpr int64_t DIV_BATCH_MAX_QUOTIENT = int64_t(1) << 50;
+
+#if defined(ENABLE_AVX512_DIV_BATCH) || \
+    defined(ENABLE_MULTIARCH_AVX512_DQ)
+
+/// q[i] = x / d[i] for 0 <= i < n. x_lo are the lower
+/// 64 bits of x and x_dbl is x converted to double.
+///
+#if defined(ENABLE_MULTIARCH_AVX512_DQ)
+  __attribute__ ((target ("avx512f,avx512dq")))
+#endif
+inline void fast_div_batch_avx512(uint64_t x_lo,
+                                  double x_dbl,
+                                  const uint64_t* d,
+                                  uint64_t* q,
+                                  int n)
+{
+  __m512d vx = _mm512_set1_pd(x_dbl);
+  __m512i vx_lo = _mm512_set1_epi64((int64_t) x_lo);
+  __m512i vone = _mm512_set1_epi64(1);
+  __m512i vzero = _mm512_setzero_si512();
+
+  for (int i = 0; i < n; i += 8)
+  {
+    int size = (n - i < 8) ? n - i : 8;
+    __mmask8 mask = (__mmask8) (0xff >> (8 - size));
+    __m512i vd = _mm512_maskz_loadu_epi64(mask, &d[i]);
+    __m512d vq_dbl = _mm512_div_pd(vx, _mm512_cvtepu64_pd(vd));
+    __m512i vq = _mm512_cvttpd_epu64(vq_dbl);
+
+    // The remainder r = x - q * d is small, it is
+    // computed exactly using 64-bit wrap around arithmetic.
+    // r < 0:  q is 1 too large.
+    // r >= d: q is 1 too small.
+    __m512i vr = _mm512_sub_epi64(vx_lo, _mm512_mullo_epi64(vq, vd));
+    __mmask8 too_large = _mm512_cmplt_epi64_mask(vr, vzero);
+    __mmask8 too_small = _mm512_mask_cmpge_epi64_mask(~too_large, vr, vd);
+    vq = _mm512_mask_sub_epi64(vq, too_large, vq, vone);
+    vq = _mm512_mask_add_epi64(vq, too_small, vq, vone);
+    _mm512_mask_storeu_epi64(&q[i], mask, vq);
+  }
+}
+
+#endif
+
+/// Returns true if fast_div_batch() uses SIMD division.
+/// Otherwise fast_div_batch() uses scalar integer division
+/// and it is faster to divide without batching.
+///
+ALWAYS_INLINE bool is_fast_div_batch()
+{
+#if defined(ENABLE_AVX512_DIV_BATCH)
+  return true;
+#elif defined(ENABLE_MULTIARCH_AVX512_DQ)
+  return cpu_supports_avx512_dq;
+#else
+  return false;
+#endif
+}
+
+/// q[i] = x / d[i] for 0 <= i < n.
+/// @pre x / d[i] < DIV_BATCH_MAX_QUOTIENT.
+///
+template <typename X>
+ALWAYS_INLINE void fast_div_batch(X x,
+                                  const uint64_t* d,
+                                  uint64_t* q,
+                                  int n)
+{
+  ASSERT(x >= 0);
+  ASSERT(n <= DIV_BATCH_SIZE);
+
+#if defined(ENABLE_AVX512_DIV_BATCH)
+  fast_div_batch_avx512((uint64_t) x, (double) x, d, q, n);
+#else
+  #if defined(ENABLE_MULTIARCH_AVX512_DQ)
+  if (cpu_supports_avx512_dq)
+  {
+    fast_div_batch_avx512((uint64_t) x, (double) x, d, q, n);
+    return;
+  }
+  #endif
+
+  for (int i = 0; i < n; i++)
+    q[i] = fast_div64(x, d[i]);
+#endif
+}
+
+/// Compute the contribution of the special leaves
+/// x / (prime * m) with min_m < m <= max_m of the current
+/// segment. Used by the hard special leaves of the
+/// Deleglise-Rivat algorithm and by D(x, y) of Xavier
+/// Gourdon's algorithm, is_leaf(m) tells whether m is a
+/// leaf for the current prime. The m values that are
+/// leaves are first gathered into a small buffer and then
+/// the x / (prime * m) divisions are computed using SIMD
+/// division. As m is decreasing the stop values are
+/// increasing which is required by sieve.count(stop).
+///
+template <typename T, typename FactorTable, typename Sieve, typename IsLeaf>
+T leaves_div_batch(T xp,
+                   int64_t phi_b,
+                   int64_t min_m,
+                   int64_t max_m,
+                   int64_t low,
+                   const FactorTable& factor,
+                   Sieve& sieve,
+                   IsLeaf is_leaf)
+{
+  T sum = 0;
+  uint64_t pm[DIV_BATCH_SIZE];
+  uint64_t xpm[DIV_BATCH_SIZE];
+  int64_t mu_m[DIV_BATCH_SIZE];
+
+  for (int64_t m = max_m; m > min_m;)
+  {
+    int n = 0;
+
+    for (; m > min_m && n < DIV_BATCH_SIZE; m--)
+    {
+      if (is_leaf(m))
+      {
+        pm[n] = factor.to_number(m);
+        mu_m[n] = factor.mu(m);
+        n++;
+      }
+    }
+
+    fast_div_batch(xp, pm, xpm, n);
+
+    for (int i = 0; i < n; i++)
+    {
+      int64_t stop = xpm[i] - low;
+      int64_t phi_xpm = phi_b + sieve.count(stop);
+      sum -= mu_m[i] * phi_xpm;
+    }
+  }
+
+  return sum;
+}
+
+/// Compute the contribution of the special leaves
+/// x / (prime * primes[l]) with primes[l] > min_m of the
+/// current segment using SIMD division. The stop values
+/// are increasing, hence all sieve.count(stop) calls of a
+/// batch are a single forward sweep over the sieve array.
+///
+template <typename T, typename Primes, typename Sieve>
+T leaves_2primes_div_batch(T xp,
+                           int64_t phi_b,
+                           int64_t l,
+                           int64_t min_m,
+                           int64_t low,
+                           const Primes& primes,
+                           Sieve& sieve)
+{
+  T sum = 0;
+  uint64_t q[DIV_BATCH_SIZE];
+  uint64_t xpq[DIV_BATCH_SIZE];
+
+  while (primes[l] > min_m)
+  {
+    int n = 0;
+
+    for (; primes[l] > min_m && n < DIV_BATCH_SIZE; l--)
+      q[n++] = primes[l];
+
+    fast_div_batch(xp, q, xpq, n);
+
+    for (int i = 0; i < n; i++)
+    {
+      int64_t stop = xpq[i] - low;
+      int64_t phi_xpq = phi_b + sieve.count(stop);
+      sum += phi_xpq;
+    }
+  }
+
+  return sum;
+}
+
+} // namespace
+
+#endif
@@ -11,6 +11,7 @@
 
 #include <int128_t.hpp>
 #include <print.hpp>
+#include <Vector.hpp>
 
 #include <stdint.h>
 
@@ -24,6 +25,12 @@ int64_t AC(int64_t x, int64_t y, int64_t z, int64_t k, int threads, bool print =
 int64_t B(int64_t x, int64_t y, int threads, bool print = is_print());
 int64_t D(int64_t x, int64_t y, int64_t z, int64_t k, int64_t d_approx, int threads, bool print = is_print());
 
+/// Batch functions, used to compute pi(x) for multiple
+/// x that share the same y, z and k.
+Vector<int64_t> pi_gourdon_64(const Vector<int64_t>& x, int threads, bool print = is_print());
+Vector<int64_t> AC(const Vector<int64_t>& x, int64_t y, int64_t z, int64_t k, int threads, bool print = is_print());
+Vector<int64_t> D(const Vector<int64_t>& x, int64_t y, int64_t z, int64_t k, const Vector<int64_t>& d_approx, int threads, bool print = is_print());
+
 #ifdef HAVE_INT128_T
 
 int128_t pi_gourdon(int128_t x, int threads);
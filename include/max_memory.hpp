@@ -0,0 +1,65 @@
+///
+/// @file  max_memory.hpp
+/// @brief Predict the memory usage of Xavier Gourdon's algorithm
+///        and of the Deleglise-Rivat algorithm and fit the
+///        computation into the memory limit set using
+///        set_max_memory() (--max-memory=BYTES).
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef MAX_MEMORY_HPP
+#define MAX_MEMORY_HPP
+
+#include <int128_t.hpp>
+#include <stdint.h>
+
+namespace primecount {
+
+/// Max size of the PhiCache in bytes (per thread)
+int64_t get_phi_cache_size();
+
+/// Number of FactorTableD segments required
+/// in order not to exceed the memory limit.
+int get_max_memory_segments();
+
+/// Predicted peak memory usage in bytes
+int64_t gourdon_memory(maxint_t x, int64_t y, int64_t z, int threads);
+int64_t deleglise_rivat_memory(maxint_t x, int64_t y, int threads);
+
+/// If a memory limit is set, the constructor decreases the
+/// PhiCache size, splits the FactorTableD into segments,
+/// decreases the alpha tuning factors (i.e. y and z) and the
+/// number of threads (in that order) until the predicted
+/// memory usage is below the memory limit. Throws a
+/// primecount_error if this is not possible or if another
+/// pi(x) computation with a memory limit is already running.
+/// The destructor restores the default PhiCache size and
+/// FactorTableD segments. Nested pi(x) computations (e.g.
+/// pi_noprint() inside the B formula) use the PhiCache size
+/// of the outermost pi(x) computation and a single
+/// FactorTableD segment.
+///
+class MaxMemory
+{
+public:
+  /// Xavier Gourdon's algorithm
+  MaxMemory(maxint_t x, int64_t& y, int64_t& z, int& threads, bool is_segmented = true);
+  /// Deleglise-Rivat algorithm
+  MaxMemory(maxint_t x, int64_t& y, int& threads);
+  ~MaxMemory();
+  MaxMemory(const MaxMemory&) = delete;
+  MaxMemory& operator=(const MaxMemory&) = delete;
+
+private:
+  bool lock();
+  void unlock();
+  bool is_owner_ = false;
+};
+
+} // namespace
+
+#endif
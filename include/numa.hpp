@@ -0,0 +1,99 @@
+///
+/// @file  numa.hpp
+/// @brief Optional NUMA mode (--numa). On multi-socket servers
+///        the read-only lookup tables of the D formula are first
+///        touched by whichever thread initializes them, hence
+///        the threads of the other NUMA nodes access them through
+///        the slow inter-socket link. In NUMA mode each OpenMP
+///        thread is pinned to the CPUs of one NUMA node and each
+///        NUMA node gets its own copy of the lookup tables.
+///
+///        The NUMA topology is read from
+///        /sys/devices/system/node/node*/cpulist (Linux only),
+///        other systems are treated as a single NUMA node.
+///        --numa=N simulates N NUMA nodes by splitting the CPUs
+///        into N groups, this is used for testing.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace primecount {
+
+/// @nodes: 0 = detect the NUMA nodes,
+///         N > 0 = simulate N NUMA nodes.
+///
+void set_numa(int nodes);
+void disable_numa();
+bool is_numa();
+int numa_nodes();
+
+/// Pins the calling OpenMP thread to the CPUs of
+/// its NUMA node, the threads are evenly distributed
+/// amongst the NUMA nodes. The previous CPU affinity
+/// is restored by the destructor.
+///
+class NumaThread
+{
+public:
+  NumaThread(int threads);
+  ~NumaThread();
+  NumaThread(const NumaThread&) = delete;
+  NumaThread& operator=(const NumaThread&) = delete;
+  int node() const { return node_; }
+
+private:
+  int node_ = 0;
+  bool is_pinned_ = false;
+  std::vector<unsigned char> old_affinity_;
+};
+
+/// Read-only lookup table with one copy per NUMA node. The
+/// copy of each node is created by the first thread of that
+/// node which accesses it, hence the memory pages are
+/// allocated on that node (first touch policy).
+/// If NUMA mode is disabled (or if there is only a single
+/// NUMA node) the original table is used.
+///
+template <typename T>
+class NumaReplicas
+{
+public:
+  NumaReplicas(const T& table) :
+    table_(table),
+    nodes_(is_numa() && numa_nodes() > 1 ? numa_nodes() : 0),
+    replicas_(nodes_),
+    once_(new std::once_flag[nodes_])
+  { }
+
+  const T& get(int node)
+  {
+    if (node >= nodes_)
+      return table_;
+
+    std::call_once(once_[node], [&] {
+      replicas_[node].reset(new T(table_));
+    });
+
+    return *replicas_[node];
+  }
+
+private:
+  const T& table_;
+  int nodes_;
+  std::vector<std::unique_ptr<T>> replicas_;
+  std::unique_ptr<std::once_flag[]> once_;
+};
+
+} // namespace
+
+#endif
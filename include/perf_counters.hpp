@@ -0,0 +1,83 @@
+///
+/// @file  perf_counters.hpp
+/// @brief Optional hardware performance counters (cmake
+///        -DWITH_PERF_COUNTERS=ON, Linux only). The hot kernels
+///        (D_thread, S2_hard_thread, A, C1, C2 and B_thread) are
+///        wrapped with a PerfCounters object which counts the
+///        CPU cycles, instructions, last level cache misses and
+///        branch misses of the calling thread using
+///        perf_event_open(). The counts are aggregated per formula
+///        and printed at the end of the computation. This way one
+///        can find out whether a formula is e.g. bound by integer
+///        division or by cache misses. Nested pi(x) computations
+///        (e.g. pi_noprint() inside B_thread) are not counted
+///        separately, their work is included in the counts of
+///        the enclosing kernel (e.g. B).
+///
+///        If perf events are not available (e.g. inside a
+///        virtual machine or if /proc/sys/kernel/perf_event_paranoid
+///        is too restrictive) the counters are silently disabled.
+///        Without WITH_PERF_COUNTERS PerfCounters is a no-op.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+namespace primecount {
+
+struct PerfTotals
+{
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t llc_misses = 0;
+  uint64_t branch_misses = 0;
+  /// Number of measured kernel calls
+  uint64_t calls = 0;
+};
+
+#if defined(ENABLE_PERF_COUNTERS)
+
+class PerfCounters
+{
+public:
+  PerfCounters(const char* formula);
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+private:
+  const char* formula_;
+  uint64_t start_[4];
+  bool is_active_ = false;
+};
+
+#else
+
+class PerfCounters
+{
+public:
+  PerfCounters(const char*) { }
+};
+
+#endif
+
+/// Returns false if primecount has been built without
+/// WITH_PERF_COUNTERS or if perf events are unavailable.
+///
+bool is_perf_counters();
+std::map<std::string, PerfTotals> get_perf_counters();
+void reset_perf_counters();
+void print_perf_counters();
+
+} // namespace
+
+#endif
@@ -1,7 +1,10 @@
 ///
 /// @file  primecount-config.hpp
 /// @brief Default CPU cache sizes and maximum CPU cache line size
-///        that will be used by primecount's algorithms.
+///        that will be used by primecount's algorithms. The
+///        CPU cache sizes are detected at runtime (see
+///        cpu_cache.cpp), the default cache sizes are only used
+///        if cache size detection fails.
 ///
 /// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
 ///
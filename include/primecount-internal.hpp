@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <algorithm>
 #include <string>
+#include <vector>
 #include <utility>
 
 namespace primecount {
@@ -34,9 +35,14 @@ int64_t pi_primesieve(int64_t x);
 
 std::string pi(const std::string& x, int threads);
 int64_t pi(int64_t x, int threads);
+std::vector<int64_t> pi(const std::vector<int64_t>& x, int threads);
+std::vector<std::string> pi(const std::vector<std::string>& x, int threads);
 int64_t pi_noprint(int64_t x, int threads);
+bool is_nested();
 int64_t pi_deleglise_rivat(int64_t x, int threads);
 int64_t nth_prime(int64_t n, int threads);
+int64_t pi_delta(int64_t x1, int64_t pi_x1, int64_t x2, int threads);
+int64_t count_primes(int64_t a, int64_t b, int threads);
 
 int64_t pi_cache(int64_t x, bool print = is_print());
 int64_t pi_deleglise_rivat_64(int64_t x, int threads, bool print = is_print());
@@ -72,6 +78,8 @@ int get_status_precision(maxint_t x);
 void set_alpha(double alpha);
 void set_alpha_y(double alpha_y);
 void set_alpha_z(double alpha_z);
+void set_factor_table_segments(int segments);
+int get_factor_table_segments();
 double get_alpha(maxint_t x, int64_t y);
 double get_alpha_y(maxint_t x, int64_t y);
 double get_alpha_z(int64_t y, int64_t z);
@@ -54,6 +54,35 @@ int64_t primecount_pi(int64_t x);
  */
 int primecount_pi_str(const char* x, char* res, size_t len);
 
+/*
+ * Count the number of primes <= x[i] for each of the n values
+ * of the x array and store the results in the res array.
+ * This is faster than calling primecount_pi(x) n times: the
+ * x values are sorted and nearby x values share the same
+ * lookup tables which are initialized only once.
+ * Returns -1 if an error occurs, else returns 0.
+ */
+int primecount_pi_batch(const int64_t* x, int64_t* res, size_t n);
+
+/*
+ * Count the number of primes <= x2 using a known pi_x1 = pi(x1).
+ * If x1 and x2 are close to each other, only the primes between
+ * x1 and x2 are counted using the segmented sieve of Eratosthenes,
+ * else pi(x2) is computed from scratch. x2 may be < x1.
+ * @pre pi_x1 = pi(x1).
+ * Returns -1 if an error occurs.
+ */
+int64_t primecount_pi_delta(int64_t x1, int64_t pi_x1, int64_t x2);
+
+/*
+ * Count the number of primes inside [a, b].
+ * Small intervals are sieved using the segmented sieve of
+ * Eratosthenes, for large intervals pi(b) - pi(a - 1) is
+ * computed using Xavier Gourdon's algorithm.
+ * Returns -1 if an error occurs.
+ */
+int64_t primecount_count_primes(int64_t a, int64_t b);
+
 /*
  * Partial sieve function (a.k.a. Legendre-sum).
  * phi(x, a) counts the numbers <= x that are not divisible
@@ -88,6 +117,16 @@ int primecount_get_num_threads(void);
 /*  Set the number of threads */
 void primecount_set_num_threads(int num_threads);
 
+/*  Get the currently set memory limit in bytes */
+int64_t primecount_get_max_memory(void);
+
+/*
+ * Set a memory limit in bytes for pi(x), 0 = no limit.
+ * In order not to exceed the memory limit pi(x) uses
+ * smaller caches, smaller lookup tables and fewer threads.
+ */
+void primecount_set_max_memory(int64_t bytes);
+
 /* Get the primecount version number, in the form “i.j” */
 const char* primecount_version(void);
 
@@ -13,8 +13,11 @@
 #ifndef PRIMECOUNT_HPP
 #define PRIMECOUNT_HPP
 
+#include <functional>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 #define PRIMECOUNT_VERSION "7.14"
@@ -54,6 +57,107 @@ int64_t pi(int64_t x);
 ///
 std::string pi(const std::string& x);
 
+/// Count the number of primes <= x for each x of the input
+/// vector, the results are returned in the same order. This is
+/// faster than calling pi(x) for each x separately: the x values
+/// are sorted and nearby x values share the same lookup tables
+/// (primes, PiTable, FactorTable) which are initialized only once.
+/// Throws a primecount_error if an error occurs.
+///
+std::vector<int64_t> pi(const std::vector<int64_t>& x);
+
+/// 128-bit batch prime counting function.
+/// Count the number of primes <= x for each x of the input
+/// vector, the results are returned in the same order.
+///
+/// @param x Vector of integer strings e.g. "12345".
+///          Note that x must be <= get_max_x().
+/// Throws a primecount_error if an error occurs.
+///
+std::vector<std::string> pi(const std::vector<std::string>& x);
+
+/// Count the number of primes <= x2 using a known pi_x1 = pi(x1).
+/// If x1 and x2 are close to each other, only the primes between
+/// x1 and x2 are counted using the segmented sieve of Eratosthenes,
+/// else pi(x2) is computed from scratch. x2 may be < x1.
+/// @pre pi_x1 = pi(x1).
+/// Throws a primecount_error if an error occurs.
+///
+/// Run time: O(min(|x2 - x1| + x2^(1/2), x2^(2/3) / (log x2)^2))
+///
+int64_t pi_delta(int64_t x1, int64_t pi_x1, int64_t x2);
+
+/// Count the number of primes inside [a, b].
+/// Small intervals are sieved using the segmented sieve of
+/// Eratosthenes, for large intervals pi(b) - pi(a - 1) is
+/// computed using Xavier Gourdon's algorithm.
+/// Throws a primecount_error if an error occurs.
+///
+/// Run time: O(min(b - a + b^(1/2), b^(2/3) / (log b)^2))
+///
+int64_t count_primes(int64_t a, int64_t b);
+
+/// Handle of an asynchronous pi(x) computation that runs in a
+/// background thread, see pi_async(x). The destructor cancels
+/// the computation (if it is still running) and waits until the
+/// background thread has exited.
+///
+class PiAsync
+{
+public:
+  PiAsync(PiAsync&&) noexcept;
+  PiAsync& operator=(PiAsync&&) noexcept;
+  ~PiAsync();
+
+  /// Returns true if the computation has finished
+  bool poll() const;
+
+  /// Wait until the computation has finished and return pi(x).
+  /// Throws a primecount_error if an error occurs or if the
+  /// computation has been cancelled.
+  ///
+  std::string wait();
+
+  /// Cancel the computation, all threads stop once they have
+  /// finished their current chunk of work (usually within
+  /// milliseconds).
+  ///
+  void cancel();
+
+  /// Progress of the computation in percent (0 to 100).
+  double percent() const;
+
+  struct State;
+
+private:
+  friend PiAsync pi_async(const std::string&, const std::function<void(double)>&);
+  PiAsync(std::shared_ptr<State> state);
+  std::shared_ptr<State> state_;
+};
+
+/// Start counting the number of primes <= x in a background
+/// thread and return immediately. The optional progress callback
+/// is called (from one of primecount's threads) with the progress
+/// in percent. Only one asynchronous computation can run at a
+/// time and the other primecount functions must not be called
+/// while it is running.
+/// Throws a primecount_error if another asynchronous
+/// computation is still running.
+///
+PiAsync pi_async(const std::string& x,
+                 const std::function<void(double)>& progress = nullptr);
+PiAsync pi_async(int64_t x,
+                 const std::function<void(double)>& progress = nullptr);
+
+/// Enable machine-readable output: the formulas of the pi(x)
+/// computation report their parameters, status and results as
+/// single-line JSON records which are passed to the callback.
+/// The result records of the A + C, D and S2_hard formulas also
+/// contain the number of chunks, segments and the (initialization)
+/// time of each thread. Pass nullptr to disable.
+///
+void set_json_callback(const std::function<void(const std::string&)>& callback);
+
 /// Partial sieve function (a.k.a. Legendre-sum).
 /// phi(x, a) counts the numbers <= x that are not divisible
 /// by any of the first a primes.
@@ -85,6 +189,18 @@ int get_num_threads();
 /// Set the number of threads
 void set_num_threads(int num_threads);
 
+/// Get the currently set memory limit in bytes
+int64_t get_max_memory();
+
+/// Set a memory limit in bytes for pi(x), 0 = no limit.
+/// In order not to exceed the memory limit pi(x) uses
+/// smaller caches, smaller lookup tables (even if the
+/// alpha tuning factors have been set explicitly) and
+/// fewer threads. Throws a primecount_error if the
+/// memory limit is too small.
+///
+void set_max_memory(int64_t bytes);
+
 /// Get the primecount version number, in the form “i.j”
 std::string primecount_version();
 
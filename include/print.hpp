@@ -26,22 +26,38 @@ namespace primecount {
 
 void set_print(bool print);
 void set_print_variables(bool print_variables);
+void set_print_json(bool print_json);
 
 bool is_print();
 bool is_print_combined_result();
+bool is_print_json();
 
 void print(string_view_t str);
 void print(string_view_t str, maxint_t res);
+
+/// A formula starts with print_header("D(x, y)") and ends
+/// with print("D", res, time) (or print_footer()).
+///
+void print_header(string_view_t formula);
+void print_footer();
 void print(string_view_t str, maxint_t res, double time);
 void print(maxint_t x, int64_t y, int64_t z, int64_t c, int threads);
 void print_vars(maxint_t x, int64_t y, int threads);
 void print_vars(maxint_t x, int64_t y, int64_t c, int threads);
 void print_seconds(double seconds);
+void print_max_memory(int64_t predicted_memory);
 
 void print_gourdon(maxint_t x, int64_t y, int64_t z, int64_t k, int threads);
 void print_gourdon_vars(maxint_t x, int64_t y, int threads);
 void print_gourdon_vars(maxint_t x, int64_t y, int64_t z, int64_t k,  int threads);
 
+/// JSON mode (--json): the formulas print single-line
+/// JSON records instead of free-form text.
+///
+void print_json_status(double percent);
+void print_json_result(maxint_t res, double seconds);
+void add_thread_stats(int64_t chunks, int64_t segments, double init_secs, double secs);
+
 } // namespace
 
 #endif
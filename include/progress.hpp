@@ -0,0 +1,80 @@
+///
+/// @file  progress.hpp
+/// @brief Progress reporting and cancellation of the asynchronous
+///        pi_async(x) computation. The load balancers report the
+///        progress of the current formula and stop assigning work
+///        to the threads once the computation has been cancelled.
+///        pi_gourdon(x) maps the progress of each formula to the
+///        progress of the entire pi(x) computation.
+///
+///        The state is owned by the pi_async(x) computation, other
+///        pi(x) computations that run at the same time are neither
+///        cancelled nor do they report progress.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace primecount {
+
+class Progress
+{
+public:
+  /// The callback is called with the progress (in
+  /// percent) of the entire pi(x) computation.
+  ///
+  Progress(const std::function<void(double)>& callback);
+
+  /// The current formula corresponds to
+  /// [begin, end] percent of the entire computation.
+  ///
+  void set_range(double begin, double end);
+
+  /// Report the progress (in percent)
+  /// of the current formula.
+  ///
+  void report(double percent);
+
+  void cancel();
+  bool is_cancelled() const;
+
+  /// Throws a primecount_error if the
+  /// computation has been cancelled.
+  ///
+  void check_cancelled() const;
+
+private:
+  std::function<void(double)> callback_;
+  std::atomic<bool> is_cancelled_{false};
+  std::mutex mutex_;
+  double begin_ = 0;
+  double end_ = 100;
+  double percent_ = 0;
+  double time_ = 0;
+};
+
+/// Progress of the pi_async(x) computation that runs on the
+/// calling thread, nullptr for all other pi(x) computations
+/// and for nested pi(x) computations. OpenMP threads must not
+/// call get_progress(), the load balancers call it in their
+/// constructor which runs on the calling thread.
+///
+Progress* get_progress();
+
+/// Used by pi_async(x) to set the
+/// progress of the calling thread.
+///
+void set_progress(Progress* progress);
+
+} // namespace
+
+#endif
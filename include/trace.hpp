@@ -0,0 +1,55 @@
+///
+/// @file  trace.hpp
+/// @brief Load balancing telemetry (--trace=FILE). LoadBalancerS2
+///        and LoadBalancerAC record each chunk of work processed
+///        by each thread. At the end of the computation the trace
+///        is written to a CSV file (or to a JSON file if the file
+///        name ends with .json). This way one can e.g. find idle
+///        threads near the end of the computation.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <stdint.h>
+#include <string>
+
+namespace primecount {
+
+struct TraceChunk
+{
+  std::string formula;
+  int thread;
+  /// Seconds elapsed since the start of the
+  /// formula when the chunk was assigned.
+  double start;
+  int64_t low;
+  int64_t segments;
+  int64_t segment_size;
+  /// Time waiting for the load balancer's lock
+  double wait_secs;
+  double init_secs;
+  double secs;
+};
+
+void set_trace_file(const std::string& filename);
+bool is_trace();
+
+/// Nested pi(x) computations (see is_nested())
+/// must not add their chunks to the trace.
+///
+void add_trace_chunk(const TraceChunk& chunk);
+
+/// Write all chunks recorded so far to the trace
+/// file, throws a primecount_error if this fails.
+///
+void write_trace();
+
+} // namespace
+
+#endif
@@ -0,0 +1,58 @@
+///
+/// @file  tune.hpp
+/// @brief Machine specific alpha tuning profile (--tune). Our
+///        default alpha tuning factors have been determined by
+///        running benchmarks on a few CPUs, on other CPUs
+///        different alpha tuning factors may be significantly
+///        faster. primecount --tune measures the fastest alpha
+///        tuning factors of the Deleglise-Rivat and Gourdon
+///        algorithms for x = 10^10, 10^11, ... on the current
+///        machine and stores them in a profile file.
+///
+///        The profile contains the ratio of the fastest to our
+///        default alpha tuning factor for each sampled x. For
+///        other x the ratio is interpolated (linearly in log(x)),
+///        for x larger than the largest sampled x the ratio of
+///        the largest sampled x is used.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#ifndef TUNE_HPP
+#define TUNE_HPP
+
+#include <int128_t.hpp>
+#include <string>
+
+namespace primecount {
+
+/// Default profile file: $PRIMECOUNT_PROFILE or
+/// $HOME/.primecount_profile
+///
+std::string default_tune_profile();
+
+/// Load the tuning profile, if the
+/// file does not exist nothing happens.
+///
+void load_tune_profile(const std::string& filename);
+void clear_tune_profile();
+bool is_tune_profile();
+
+/// Benchmark the alpha tuning factors for x = 10^10, ...
+/// <= x_max and store the fastest ones in filename.
+///
+void tune(maxint_t x_max, int threads, const std::string& filename);
+
+/// Adjust our default alpha tuning factors
+/// using the tuning profile.
+///
+double tuned_alpha_deleglise_rivat(maxint_t x, double alpha);
+double tuned_alpha_yz_gourdon(maxint_t x, double alpha_yz);
+double tuned_alpha_z_gourdon(maxint_t x, double alpha_z);
+
+} // namespace
+
+#endif
@@ -12,8 +12,10 @@
 
 #include <LoadBalancerP2.hpp>
 #include <primecount-internal.hpp>
+#include <print.hpp>
 #include <imath.hpp>
 #include <min.hpp>
+#include <progress.hpp>
 
 #include <stdint.h>
 #include <algorithm>
@@ -24,15 +26,19 @@
 
 namespace primecount {
 
-/// We need to sieve [sqrt(x), sieve_limit[
+/// We need to sieve [low, sieve_limit[
+/// with low = sqrt(x) (unless --low=L is used).
+///
 LoadBalancerP2::LoadBalancerP2(maxint_t x,
+                               int64_t low,
                                int64_t sieve_limit,
                                int threads,
                                bool is_print) :
-  low_(isqrt(x)),
+  low_(low),
   sieve_limit_(sieve_limit),
   precision_(get_status_precision(x)),
-  is_print_(is_print)
+  is_print_(is_print),
+  progress_(get_progress())
 {
   low_ = min(low_, sieve_limit_);
   int64_t dist = sieve_limit_ - low_;
@@ -63,16 +69,22 @@ bool LoadBalancerP2::get_work(int64_t& low, int64_t& high)
   LockGuard lockGuard(lock_);
   print_status();
 
+  if (progress_)
+    progress_->report(get_percent(low_, sieve_limit_));
+  if (progress_ && progress_->is_cancelled())
+    return false;
+
   // Calculate the remaining sieving distance
   low_ = min(low_, sieve_limit_);
   int64_t dist = sieve_limit_ - low_;
 
   // When a single thread is used (and printing is disabled) we can
   // set thread_dist to the entire sieving distance as load balancing
-  // is only useful for multi-threading.
+  // is only useful for multi-threading. pi_async(x) requires
+  // multiple chunks for progress reporting and cancellation.
   if (threads_ == 1)
   {
-    if (!is_print_)
+    if (!is_print_ && !progress_)
       thread_dist_ = dist;
   }
   else
@@ -104,6 +116,17 @@ bool LoadBalancerP2::get_work(int64_t& low, int64_t& high)
   return low < sieve_limit_;
 }
 
+/// Exceptions must not be thrown inside an OpenMP
+/// parallel region, hence this is called after the
+/// parallel region. The sum of a cancelled
+/// computation is incomplete.
+///
+void LoadBalancerP2::check_cancelled() const
+{
+  if (progress_)
+    progress_->check_cancelled();
+}
+
 void LoadBalancerP2::print_status()
 {
   if (is_print_)
@@ -116,6 +139,13 @@ void LoadBalancerP2::print_status()
     {
       time_ = time;
       double percent = get_percent(low_, sieve_limit_);
+
+      if (is_print_json())
+      {
+        print_json_status(percent);
+        return;
+      }
+
       std::ostringstream status;
       status << "\rStatus: " << std::fixed << std::setprecision(precision_) << percent << '%';
       std::cout << status.str() << std::flush;
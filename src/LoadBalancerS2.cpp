@@ -22,6 +22,21 @@
 ///        order to prevent that 1 thread will run much longer than
 ///        all the other threads.
 ///
+///        For very large computations the LoadBalancerS2 also
+///        periodically stores its state in a backup file. Since the
+///        threads finish their work out of order the backup file
+///        contains the sum of all finished chunks as well as the
+///        list of unfinished chunks. When resuming, the unfinished
+///        chunks are recomputed first.
+///
+///        The LoadBalancerS2 also supports distributed computing: the
+///        coordinator process assigns the chunks to the threads of
+///        the worker processes (see distributed.hpp). A worker sends
+///        the sum of its previous chunk together with its request
+///        for new work, hence the coordinator accumulates the sum
+///        of all chunks exactly as in a single process computation.
+///        The chunks of workers that have died are reassigned.
+///
 /// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
@@ -29,6 +44,10 @@
 ///
 
 #include <LoadBalancerS2.hpp>
+#include <backup.hpp>
+#include <cpu_cache.hpp>
+#include <distributed.hpp>
+#include <primecount.hpp>
 #include <primecount-config.hpp>
 #include <primecount-internal.hpp>
 #include <StatusS2.hpp>
@@ -36,8 +55,25 @@
 #include <imath.hpp>
 #include <int128_t.hpp>
 #include <min.hpp>
+#include <print.hpp>
+#include <progress.hpp>
+#include <trace.hpp>
 
 #include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+/// Store the state of the computation in
+/// the backup file every 60 seconds.
+const double backup_secs = 60;
+
+} // namespace
 
 namespace primecount {
 
@@ -46,10 +82,15 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
                                maxint_t sum_approx,
                                int threads,
                                bool is_print) :
+  x_(x),
   sieve_limit_(sieve_limit),
   sum_approx_(sum_approx),
   time_(get_time()),
   is_print_(is_print),
+  is_coordinator_(is_coordinator()),
+  is_nested_(is_nested()),
+  is_trace_(is_trace() && !is_nested_),
+  progress_(get_progress()),
   status_(x)
 {
   lock_.init(threads);
@@ -58,25 +99,33 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
   // array size that matches your CPU's L1 data cache size
   // (per core) or that is slightly larger than your L1 cache
   // size but smaller than your L2 cache size (per core).
+  // The cache sizes are detected at runtime.
   // Also, the segment_size must be >= sqrt(sieve_limit).
-  int64_t sieve_bytes = L1D_CACHE_SIZE * 2;
+  int64_t sieve_bytes = min(get_l1d_cache_size() * 2, get_l2_cache_size());
   int64_t numbers_per_byte = 30;
   int64_t sqrt_limit = isqrt(sieve_limit);
   max_size_ = max(sieve_bytes * numbers_per_byte, sqrt_limit);
 
+  int64_t segment_size;
+  int64_t segments;
+
   if (threads == 1 &&
-      !is_print)
+      !is_print &&
+      !progress_ &&
+      !is_coordinator())
   {
     // When a single thread is used (and printing is disabled)
     // we can set segment_size to its maximum size as load
     // balancing is only useful for multi-threading.
-    segment_size_ = max_size_;
-    // Currently our Sieve.cpp does not rebalance its counters
-    // data structure. However, if we process the computation
-    // in chunks then the sieve gets recreated for each new
-    // chunk which rebalances the counters. Therefore we limit
-    // the number of segments here.
-    segments_ = 100;
+    // pi_async(x) requires multiple chunks for progress
+    // reporting and cancellation.
+    segment_size = max_size_;
+    // Our Sieve.cpp rebalances its counters data structure
+    // for each new segment, so we don't need to recreate the
+    // sieve. But we still process the computation in chunks
+    // of 100 segments as the backup file is updated after
+    // each finished chunk.
+    segments = 100;
   }
   else
   {
@@ -84,47 +133,533 @@ LoadBalancerS2::LoadBalancerS2(maxint_t x,
     // most special leaves are in the first few
     // segments and as we need to ensure that all
     // threads are assigned an equal amount of work.
-    segment_size_ = isqrt(isqrt(x));
-    segments_ = 1;
+    segment_size = isqrt(isqrt(x));
+    segments = 1;
   }
 
   int64_t min_size = 1 << 9;
-  segment_size_ = max(min_size, segment_size_);
-  segment_size_ = Sieve::get_segment_size(segment_size_);
+  segment_size = max(min_size, segment_size);
+  segment_size_ = Sieve::get_segment_size(segment_size);
+  segments_ = segments;
 }
 
 maxint_t LoadBalancerS2::get_sum() const
 {
+  // Exceptions must not be thrown inside
+  // an OpenMP parallel region.
+  if (!error_.empty())
+    throw primecount_error(error_);
+  // The sum of a cancelled computation is incomplete
+  if (progress_)
+    progress_->check_cancelled();
+
   return sum_;
 }
 
 bool LoadBalancerS2::get_work(ThreadData& thread)
 {
+  if (is_worker_)
+    return get_remote_work(thread);
+
+  if (thread.segments > 0)
+  {
+    thread.total_chunks++;
+    thread.total_segments += thread.segments;
+    thread.total_init_secs += thread.init_secs;
+    thread.total_secs += thread.secs;
+  }
+
+  // Backups and distributed computing need to know exactly
+  // which chunks are unfinished, the trace records all chunks.
+  if (is_backup_ || is_coordinator_ || is_trace_)
+    return get_work_locked(thread);
+  else
+    return get_work_lock_free(thread);
+}
+
+/// Each thread first adds the sum of its previous chunk to the
+/// load balancer's sum and updates the load balancing settings
+/// while holding the lock, then it is assigned the next chunk.
+///
+bool LoadBalancerS2::get_work_locked(ThreadData& thread)
+{
+  double lock_time = is_trace_ ? get_time() : 0;
   LockGuard lockGuard(lock_);
   sum_ += thread.sum;
 
+  if (is_trace_)
+    trace(thread, lock_time);
+
   if (is_print_)
+    print_status(thread);
+
+  if (progress_)
+    progress_->report(status_.getTotalPercent(low_, sieve_limit_, sum_, sum_approx_));
+
+  // pi_async(x) has been cancelled, the
+  // threads stop once they have finished
+  // their current chunk of work.
+  if (is_cancelled())
   {
-    uint64_t dist = thread.segments * thread.segment_size;
-    uint64_t high = thread.low + dist;
-    status_.print(high, sieve_limit_, sum_, sum_approx_);
+    thread_finished(thread);
+    return false;
   }
 
   update_load_balancing(thread);
 
-  thread.low = low_;
-  thread.segments = segments_;
-  thread.segment_size = segment_size_;
+  if (is_backup_)
+    finish_chunk(thread);
+
+  // An expired chunk is still in unfinished_
+  bool is_expired = is_coordinator_ && get_expired_work(thread);
+  bool is_work = is_expired || get_resumed_work(thread);
+
+  if (!is_work)
+  {
+    int64_t segments = segments_;
+    int64_t segment_size = segment_size_;
+    thread.low = low_;
+    thread.segments = segments;
+    thread.segment_size = segment_size;
+    low_ += segments * segment_size;
+    is_work = thread.low < sieve_limit_;
+  }
+
   thread.sum = 0;
   thread.secs = 0;
   thread.init_secs = 0;
 
-  low_ += segments_ * segment_size_;
-  bool is_work = thread.low < sieve_limit_;
+  if (is_backup_)
+  {
+    if (is_work && !is_expired)
+      unfinished_.push_back(Chunk{thread.low, thread.segments, thread.segment_size});
+    backup();
+  }
+
+  if (!is_work)
+    thread_finished(thread);
 
   return is_work;
 }
 
+/// On servers with hundreds of threads most threads would be
+/// waiting for the lock near the start of the computation, as
+/// the chunks are tiny. Therefore the threads only try to
+/// acquire the lock: if another thread holds the lock, the sum
+/// of the previous chunk is kept (in thread.pending_sum) and
+/// the load balancing settings are not updated. The next chunk
+/// is taken from the atomic low_ without locking. Since all
+/// threads acquire the lock before exiting, the final sum is
+/// exact.
+///
+bool LoadBalancerS2::get_work_lock_free(ThreadData& thread)
+{
+  thread.pending_sum += thread.sum;
+  thread.sum = 0;
+
+  {
+    TryLockGuard tryLockGuard(lock_);
+
+    if (tryLockGuard.owns_lock())
+    {
+      sum_ += thread.pending_sum;
+      thread.pending_sum = 0;
+
+      if (is_print_)
+        print_status(thread);
+      if (progress_)
+        progress_->report(status_.getTotalPercent(low_, sieve_limit_, sum_, sum_approx_));
+      if (!is_cancelled())
+        update_load_balancing(thread);
+    }
+  }
+
+  int64_t low = low_.load(std::memory_order_relaxed);
+  int64_t segments = 0;
+  int64_t segment_size = 0;
+
+  // The chunk [low, low + segments * segment_size[ is
+  // assigned to the thread that manages to advance low_.
+  while (low < sieve_limit_ && !is_cancelled())
+  {
+    segments = segments_.load(std::memory_order_relaxed);
+    segment_size = segment_size_.load(std::memory_order_relaxed);
+    int64_t high = low + segments * segment_size;
+
+    if (low_.compare_exchange_weak(low, high, std::memory_order_relaxed))
+    {
+      thread.low = low;
+      thread.segments = segments;
+      thread.segment_size = segment_size;
+      thread.secs = 0;
+      thread.init_secs = 0;
+      return true;
+    }
+  }
+
+  LockGuard lockGuard(lock_);
+  sum_ += thread.pending_sum;
+  thread.pending_sum = 0;
+  thread_finished(thread);
+
+  return false;
+}
+
+void LoadBalancerS2::print_status(const ThreadData& thread)
+{
+  uint64_t dist = thread.segments * thread.segment_size;
+  uint64_t high = thread.low + dist;
+  status_.print(high, sieve_limit_, sum_, sum_approx_);
+}
+
+/// Record the chunk that has just been finished by the
+/// thread (--trace=FILE). The time waiting for the lock
+/// is attributed to the thread's next chunk.
+///
+void LoadBalancerS2::trace(ThreadData& thread, double lock_time)
+{
+  double time = get_time();
+
+  if (thread.id < 0)
+    thread.id = threads_++;
+
+  if (thread.segments > 0)
+    add_trace_chunk(TraceChunk{formula_, thread.id, thread.assigned_time - time_,
+                               thread.low, thread.segments, thread.segment_size,
+                               thread.wait_secs, thread.init_secs, thread.secs});
+
+  thread.assigned_time = time;
+  thread.wait_secs = time - lock_time;
+}
+
+/// In JSON mode (--json) the statistics of all
+/// threads are printed together with the result.
+/// The threads of nested pi(x) computations (e.g.
+/// inside the B formula) are not part of it.
+///
+void LoadBalancerS2::thread_finished(const ThreadData& thread)
+{
+  if (is_print_json() && !is_nested_)
+    add_thread_stats(thread.total_chunks,
+                     thread.total_segments,
+                     thread.total_init_secs,
+                     thread.total_secs);
+}
+
+/// pi_async(x) has been cancelled
+bool LoadBalancerS2::is_cancelled() const
+{
+  return progress_ && progress_->is_cancelled();
+}
+
+/// The sieving interval is processed once per pass, used by
+/// the D formula with a segmented FactorTableD. The status and
+/// progress of each pass are scaled to its share.
+///
+void LoadBalancerS2::set_pass(int64_t pass, int64_t passes)
+{
+  status_.setPass(pass, passes);
+}
+
+/// Only sieve the interval [low, high[ instead of
+/// [0, sieve_limit[, used to split the computation
+/// into chunks (--low=L --high=H).
+///
+void LoadBalancerS2::set_interval(int64_t low, int64_t high)
+{
+  start_ = low;
+  low_ = low;
+  sieve_limit_ = high;
+}
+
+/// Set the formula that is computed using this LoadBalancerS2,
+/// this enables backups and distributed computing. If the backup
+/// file contains the state of a previous computation of the same
+/// formula using the same parameters, we resume from it.
+///
+void LoadBalancerS2::set_formula(const std::string& formula,
+                                 int64_t y,
+                                 int64_t z,
+                                 int64_t k)
+{
+  formula_ = formula;
+  y_ = y;
+  z_ = z;
+  k_ = k;
+
+  // The coordinator stores the backups
+  if (is_worker())
+  {
+    is_worker_ = true;
+    return;
+  }
+
+  if (!is_backup())
+    return;
+
+  is_backup_ = true;
+  backup_time_ = get_time();
+  Backup backup = load_backup();
+
+  if (!is_resume(backup, formula_, x_, y_, z_, k_) ||
+      backup[formula_ + ".interval"] != interval())
+    return;
+
+  try
+  {
+    std::string prefix = formula_ + ".";
+    low_ = std::stoll(backup.at(prefix + "low"));
+    segments_ = std::stoll(backup.at(prefix + "segments"));
+    segment_size_ = std::stoll(backup.at(prefix + "segment_size"));
+    sum_ = to_maxint(backup.at(prefix + "sum"));
+
+    std::istringstream unfinished(backup.at(prefix + "unfinished"));
+    Chunk chunk;
+
+    while (unfinished >> chunk.low >> chunk.segments >> chunk.segment_size)
+      resumed_.push_back(chunk);
+  }
+  catch (std::exception&)
+  {
+    throw primecount_error("invalid backup file: " + backup_file());
+  }
+
+  if (is_print_)
+  {
+    double percent = status_.getTotalPercent(low_, sieve_limit_, sum_, sum_approx_);
+    std::ostringstream oss;
+    oss << "Resuming " << formula_ << " from " << backup_file()
+        << " (" << (int) percent << "%)";
+    print(oss.str().c_str());
+  }
+}
+
+/// Assign work to the worker processes until all
+/// chunks have been finished (coordinator process).
+///
+void LoadBalancerS2::serve_workers()
+{
+  serve_requests([&](const std::string& request) { return reply_worker(request); },
+                 [&] { return is_finished(); });
+}
+
+/// All work has been assigned and all
+/// assigned chunks have been finished.
+///
+bool LoadBalancerS2::is_finished() const
+{
+  return low_ >= sieve_limit_ &&
+         resumed_.empty() &&
+         remote_.empty();
+}
+
+/// Request: formula x y z k interval low segments segment_size sum init_secs secs
+/// Reply: "work low segments segment_size" or "wait" or "finished" or "error msg"
+/// "wait" means that all chunks have been assigned, but some
+/// of them may still expire and need to be reassigned.
+///
+std::string LoadBalancerS2::reply_worker(const std::string& request)
+{
+  std::istringstream iss(request);
+  std::string formula, x, sum;
+  int64_t y, z, k, start, sieve_limit;
+  ThreadData thread;
+
+  if (!(iss >> formula >> x >> y >> z >> k >> start >> sieve_limit
+            >> thread.low >> thread.segments >> thread.segment_size
+            >> sum >> thread.init_secs >> thread.secs))
+    return "error invalid request: " + request;
+
+  if (formula != formula_ ||
+      x != to_string(x_) ||
+      y != y_ || z != z_ || k != k_ ||
+      start != start_ || sieve_limit != sieve_limit_)
+  {
+    std::ostringstream oss;
+    oss << "error the coordinator computes " << formula_ << "(x = " << x_
+        << ", y = " << y_ << ", z = " << z_ << ", k = " << k_ << ")"
+        << " in [" << start_ << ", " << sieve_limit_ << "[";
+    return oss.str();
+  }
+
+  try { thread.sum = to_maxint(sum); }
+  catch (std::exception&) { return "error invalid request: " + request; }
+
+  // The worker has finished its previous chunk. If the chunk
+  // had expired and has meanwhile been finished by another
+  // worker, its sum has already been counted.
+  if (thread.segments > 0 &&
+      !remote_.finish(thread.low, thread.secs))
+  {
+    thread.sum = 0;
+    thread.segments = 0;
+  }
+
+  if (!get_work(thread))
+    return is_finished() ? "finished" : "wait";
+
+  remote_.assign({thread.low, thread.segments, thread.segment_size});
+
+  return "work " + std::to_string(thread.low) + " " +
+                   std::to_string(thread.segments) + " " +
+                   std::to_string(thread.segment_size);
+}
+
+/// Send the sum of the previous chunk to the coordinator
+/// and request a new chunk (worker process). Note that
+/// sum_ is the sum of all chunks computed by this worker.
+///
+bool LoadBalancerS2::get_remote_work(ThreadData& thread)
+{
+  try
+  {
+    {
+      LockGuard lockGuard(lock_);
+      sum_ += thread.sum;
+      if (!error_.empty())
+        return false;
+    }
+
+    while (true)
+    {
+      std::ostringstream request;
+      request << formula_ << ' ' << x_ << ' ' << y_ << ' ' << z_ << ' ' << k_ << ' '
+              << interval() << ' ' << thread.low << ' ' << thread.segments << ' ' << thread.segment_size << ' '
+              << thread.sum << ' ' << thread.init_secs << ' ' << thread.secs;
+
+      thread.sum = 0;
+      thread.secs = 0;
+      thread.init_secs = 0;
+      thread.segments = 0;
+
+      // An empty reply means that the coordinator
+      // has finished the computation and exited.
+      std::string reply = send_request(request.str());
+      std::istringstream iss(reply);
+      std::string status;
+      iss >> status;
+
+      if (status == "work" &&
+          iss >> thread.low >> thread.segments >> thread.segment_size)
+        return true;
+      if (status == "error")
+        throw primecount_error("coordinator: " + reply.substr(6));
+      if (status != "wait")
+        return false;
+
+      // Wait until an expired chunk is reassigned
+      // or until all chunks have been finished.
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+  }
+  catch (std::exception& e)
+  {
+    LockGuard lockGuard(lock_);
+    error_ = e.what();
+    return false;
+  }
+}
+
+/// Chunks that were unfinished when the
+/// backup was stored are recomputed first.
+///
+bool LoadBalancerS2::get_resumed_work(ThreadData& thread)
+{
+  if (resumed_.empty())
+    return false;
+
+  Chunk chunk = resumed_.back();
+  resumed_.resize(resumed_.size() - 1);
+  thread.low = chunk.low;
+  thread.segments = chunk.segments;
+  thread.segment_size = chunk.segment_size;
+
+  return true;
+}
+
+/// Chunks of workers that have died are reassigned
+/// to other workers (coordinator process).
+///
+bool LoadBalancerS2::get_expired_work(ThreadData& thread)
+{
+  RemoteChunks::Chunk chunk;
+
+  if (!remote_.get_expired(chunk))
+    return false;
+
+  thread.low = chunk.low;
+  thread.segments = chunk.segments;
+  thread.segment_size = chunk.segment_size;
+
+  return true;
+}
+
+/// Remove the chunk that the thread has just
+/// finished from the list of unfinished chunks.
+///
+void LoadBalancerS2::finish_chunk(const ThreadData& thread)
+{
+  // The thread has not yet processed any work
+  if (thread.segments == 0)
+    return;
+
+  for (Chunk& chunk : unfinished_)
+  {
+    if (chunk.low == thread.low)
+    {
+      chunk = unfinished_.back();
+      unfinished_.resize(unfinished_.size() - 1);
+      return;
+    }
+  }
+}
+
+/// Store the sum of all finished chunks and the list of
+/// unfinished chunks in the backup file. We also store
+/// the backup once all chunks have been finished so that
+/// the result can be read from the backup file.
+///
+void LoadBalancerS2::backup()
+{
+  double time = get_time();
+  bool is_finished = low_ >= sieve_limit_ &&
+                     unfinished_.empty() &&
+                     resumed_.empty();
+
+  if (time - backup_time_ < backup_secs &&
+      (!is_finished || is_backup_finished_))
+    return;
+
+  backup_time_ = time;
+  is_backup_finished_ = is_finished;
+
+  std::ostringstream unfinished;
+
+  for (const Chunk& chunk : resumed_)
+    unfinished << chunk.low << ' ' << chunk.segments << ' ' << chunk.segment_size << ' ';
+  for (const Chunk& chunk : unfinished_)
+    unfinished << chunk.low << ' ' << chunk.segments << ' ' << chunk.segment_size << ' ';
+
+  std::string prefix = formula_ + ".";
+  double percent = status_.getTotalPercent(low_, sieve_limit_, sum_, sum_approx_);
+  Backup backup = load_backup();
+  reset_backup(backup, formula_, x_, y_, z_, k_);
+  backup[prefix + "interval"] = interval();
+  backup[prefix + "low"] = std::to_string(low_.load());
+  backup[prefix + "segments"] = std::to_string(segments_.load());
+  backup[prefix + "segment_size"] = std::to_string(segment_size_.load());
+  backup[prefix + "sum"] = to_string(sum_);
+  backup[prefix + "unfinished"] = unfinished.str();
+  backup[prefix + "percent"] = std::to_string(is_finished ? 100 : (int) percent);
+  store_backup(backup);
+}
+
+/// The sieving interval [start, sieve_limit[
+std::string LoadBalancerS2::interval() const
+{
+  return std::to_string(start_) + " " + std::to_string(sieve_limit_);
+}
+
 void LoadBalancerS2::update_load_balancing(const ThreadData& thread)
 {
   if (thread.low > max_low_)
@@ -154,9 +689,10 @@ void LoadBalancerS2::update_load_balancing(const ThreadData& thread)
 /// Slowly increase segment_size until it reaches sqrt(sieve_limit)
 void LoadBalancerS2::update_segment_size()
 {
-  segment_size_ += segment_size_ / 16;
-  segment_size_ = min(segment_size_, max_size_);
-  segment_size_ = Sieve::get_segment_size(segment_size_);
+  int64_t segment_size = segment_size_;
+  segment_size += segment_size / 16;
+  segment_size = min(segment_size, max_size_);
+  segment_size_ = Sieve::get_segment_size(segment_size);
 }
 
 /// Increase or decrease the number of segments per thread
@@ -229,14 +765,18 @@ void LoadBalancerS2::update_number_of_segments(const ThreadData& thread)
   factor = in_between(0.5, factor, 2.0);
   double next_runtime = thread.secs * factor;
 
+  int64_t segments = segments_;
+
   if (next_runtime < min_secs)
-    segments_ *= 2;
+    segments *= 2;
   else
   {
-    double new_segments = std::round(segments_ * factor);
-    segments_ = (int64_t) new_segments;
-    segments_ = max(segments_, 1);
+    double new_segments = std::round(segments * factor);
+    segments = (int64_t) new_segments;
+    segments = max(segments, 1);
   }
+
+  segments_ = segments;
 }
 
 /// Remaining seconds till finished
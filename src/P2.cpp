@@ -110,7 +110,7 @@ T P2_OpenMP(T x,
   static_assert(pstd::is_signed<T>::value, "T must be signed integer type");
 
   int64_t xy = (int64_t)(x / max(y, 1));
-  LoadBalancerP2 loadBalancer(x, xy, threads, is_print);
+  LoadBalancerP2 loadBalancer(x, sqrtx, xy, threads, is_print);
   threads = loadBalancer.get_threads();
 
   // for (low = sqrt(x); low < x / y; low += dist)
@@ -121,6 +121,8 @@ T P2_OpenMP(T x,
       sum += P2_thread(x, y, low, high);
   }
 
+  loadBalancer.check_cancelled();
+
   return sum;
 }
 
@@ -139,7 +141,7 @@ int64_t P2(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== P2(x, y) ===");
+    print_header("P2(x, y)");
     print_vars(x, y, threads);
     time = get_time();
   }
@@ -165,7 +167,7 @@ int128_t P2(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== P2(x, y) ===");
+    print_header("P2(x, y)");
     print_vars(x, y, threads);
     time = get_time();
   }
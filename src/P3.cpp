@@ -36,7 +36,7 @@ int64_t P3(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== P3(x, a) ===");
+    print_header("P3(x, a)");
     time = get_time();
   }
 
@@ -119,6 +119,16 @@ PiTable::PiTable(uint64_t max_x, int threads) :
     init(limit, cache_limit, threads);
 }
 
+/// Copy the lookup table, used to replicate
+/// the PiTable on each NUMA node (--numa).
+///
+PiTable::PiTable(const PiTable& other) :
+  max_x_(other.max_x_)
+{
+  pi_.resize(other.pi_.size());
+  std::copy_n(other.pi_.data(), other.pi_.size(), pi_.data());
+}
+
 /// Used if PiTable larger than pi_cache
 void PiTable::init(uint64_t limit,
                    uint64_t cache_limit,
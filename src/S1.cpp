@@ -100,7 +100,7 @@ int64_t S1(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== S1(x, y) ===");
+    print_header("S1(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
@@ -126,7 +126,7 @@ int128_t S1(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== S1(x, y) ===");
+    print_header("S1(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
@@ -12,6 +12,7 @@
 
 #include <StatusS2.hpp>
 #include <primecount-internal.hpp>
+#include <print.hpp>
 #include <int128_t.hpp>
 
 #include <iostream>
@@ -86,6 +87,22 @@ double StatusS2::getPercent(int64_t low, int64_t limit, maxint_t sum, maxint_t s
   return percent;
 }
 
+/// The D formula with a segmented FactorTableD sieves the
+/// interval once per FactorTableD segment (pass), each pass
+/// is scaled to its share of the entire computation.
+///
+void StatusS2::setPass(int64_t pass, int64_t passes)
+{
+  pass_ = pass;
+  passes_ = std::max(passes, (int64_t) 1);
+}
+
+double StatusS2::getTotalPercent(int64_t low, int64_t limit, maxint_t sum, maxint_t sum_approx) const
+{
+  double percent = getPercent(low, limit, sum, sum_approx);
+  return (pass_ * 100 + percent) / passes_;
+}
+
 void StatusS2::print(double percent)
 {
   double old = percent_;
@@ -93,6 +110,13 @@ void StatusS2::print(double percent)
   if ((percent - old) >= epsilon_)
   {
     percent_ = percent;
+
+    if (is_print_json())
+    {
+      print_json_status(percent);
+      return;
+    }
+
     std::ostringstream status;
     status << "\rStatus: " << std::fixed << std::setprecision(precision_) << percent << '%';
     std::cout << status.str() << std::flush;
@@ -113,7 +137,7 @@ void StatusS2::print(int64_t low, int64_t limit, maxint_t sum, maxint_t sum_appr
   if ((time - old) >= threshold_)
   {
     time_ = time;
-    double percent = getPercent(low, limit, sum, sum_approx);
+    double percent = getTotalPercent(low, limit, sum, sum_approx);
     print(percent);
   }
 }
@@ -16,9 +16,13 @@
 #include <macros.hpp>
 #include <PiTable.hpp>
 #include <print.hpp>
+#include <Vector.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 #ifdef _OPENMP
@@ -31,6 +35,15 @@ namespace {
   int threads_ = 0;
 #endif
 
+/// Number of nested pi(x) computations of the calling thread
+thread_local int nested_ = 0;
+
+struct NestedPi
+{
+  NestedPi() { nested_++; }
+  ~NestedPi() { nested_--; }
+};
+
 } // namespace
 
 namespace primecount {
@@ -70,9 +83,89 @@ int64_t pi(int64_t x, int threads)
   return pi_gourdon_64(x, threads);
 }
 
-/// Used internally for initialization
+std::vector<int64_t> pi(const std::vector<int64_t>& x)
+{
+  return pi(x, get_num_threads());
+}
+
+std::vector<int64_t> pi(const std::vector<int64_t>& x, int threads)
+{
+  std::vector<int64_t> res(x.size());
+  std::vector<int64_t> large;
+
+  for (std::size_t i = 0; i < x.size(); i++)
+  {
+    if (x[i] <= (int64_t) 1e8)
+      res[i] = pi(x[i], threads);
+    else
+      large.push_back(x[i]);
+  }
+
+  if (large.empty())
+    return res;
+
+  // For large x Gourdon's algorithm runs fastest. We sort
+  // the x values so that nearby x values can share the
+  // same lookup tables in pi_gourdon_64().
+  std::sort(large.begin(), large.end());
+  large.erase(std::unique(large.begin(), large.end()), large.end());
+  Vector<int64_t> values(large.size());
+  std::copy(large.begin(), large.end(), values.begin());
+  Vector<int64_t> pix = pi_gourdon_64(values, threads);
+
+  for (std::size_t i = 0; i < x.size(); i++)
+  {
+    if (x[i] > (int64_t) 1e8)
+    {
+      auto iter = std::lower_bound(large.begin(), large.end(), x[i]);
+      res[i] = pix[iter - large.begin()];
+    }
+  }
+
+  return res;
+}
+
+std::vector<std::string> pi(const std::vector<std::string>& x)
+{
+  return pi(x, get_num_threads());
+}
+
+std::vector<std::string> pi(const std::vector<std::string>& x, int threads)
+{
+  std::vector<maxint_t> n(x.size());
+  std::vector<int64_t> x64;
+
+  for (std::size_t i = 0; i < x.size(); i++)
+  {
+    n[i] = to_maxint(x[i]);
+    if (n[i] <= pstd::numeric_limits<int64_t>::max())
+      x64.push_back((int64_t) n[i]);
+  }
+
+  // 64-bit x values are computed in a single batch
+  std::vector<int64_t> pix64 = pi(x64, threads);
+  std::vector<std::string> res(x.size());
+  std::size_t j = 0;
+
+  for (std::size_t i = 0; i < x.size(); i++)
+  {
+    if (n[i] <= pstd::numeric_limits<int64_t>::max())
+      res[i] = std::to_string(pix64[j++]);
+    else
+      res[i] = to_string(pi(n[i], threads));
+  }
+
+  return res;
+}
+
+/// Used internally for initialization and for nested pi(x)
+/// computations, e.g. B(x, y) computes pi(x / prime) inside
+/// its parallel region (using 1 thread) and Sigma(x, y)
+/// computes pi(sqrt(x)) using all threads.
+///
 int64_t pi_noprint(int64_t x, int threads)
 {
+  NestedPi nested;
   bool is_print = false;
 
   if (x <= PiTable::max_cached())
@@ -85,6 +178,19 @@ int64_t pi_noprint(int64_t x, int threads)
     return pi_gourdon_64(x, threads, is_print);
 }
 
+/// Nested pi(x) computations must not use the global
+/// state of the outermost pi(x) computation, e.g. they
+/// must not write into the backup file. is_nested() is
+/// only true on the thread that called pi_noprint(), the
+/// OpenMP threads of a nested computation must not call it.
+/// Hence it is called before the parallel region, e.g. the
+/// load balancers call it in their constructor.
+///
+bool is_nested()
+{
+  return nested_ > 0;
+}
+
 int64_t pi_cache(int64_t x, bool is_print)
 {
   if (x < 2)
@@ -93,9 +199,10 @@ int64_t pi_cache(int64_t x, bool is_print)
   if (is_print)
   {
     print("");
-    print("=== pi_cache(x) ===");
+    print_header("pi_cache(x)");
     print("x", x);
     print("threads", 1);
+    print_footer();
   }
 
   ASSERT(x >= 0);
@@ -163,6 +270,16 @@ int128_t pi_gourdon(int128_t x, int threads)
 
 #endif
 
+int64_t pi_delta(int64_t x1, int64_t pi_x1, int64_t x2)
+{
+  return pi_delta(x1, pi_x1, x2, get_num_threads());
+}
+
+int64_t count_primes(int64_t a, int64_t b)
+{
+  return count_primes(a, b, get_num_threads());
+}
+
 int64_t nth_prime(int64_t n)
 {
   return nth_prime(n, get_num_threads());
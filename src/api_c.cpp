@@ -14,10 +14,12 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <exception>
 #include <iostream>
+#include <vector>
 
 int64_t primecount_pi(int64_t x)
 {
@@ -71,6 +73,58 @@ int primecount_pi_str(const char* x, char* res, size_t len)
   }
 }
 
+int primecount_pi_batch(const int64_t* x, int64_t* res, size_t n)
+{
+  try
+  {
+    if (n == 0)
+      return 0;
+
+    if (!x)
+      throw primecount::primecount_error("x must not be a NULL pointer");
+
+    if (!res)
+      throw primecount::primecount_error("res must not be a NULL pointer");
+
+    std::vector<int64_t> v(x, x + n);
+    std::vector<int64_t> pix = primecount::pi(v);
+    std::copy(pix.begin(), pix.end(), res);
+
+    return 0;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_pi_batch: " << e.what() << std::endl;
+    return -1;
+  }
+}
+
+int64_t primecount_pi_delta(int64_t x1, int64_t pi_x1, int64_t x2)
+{
+  try
+  {
+    return primecount::pi_delta(x1, pi_x1, x2);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_pi_delta: " << e.what() << std::endl;
+    return -1;
+  }
+}
+
+int64_t primecount_count_primes(int64_t a, int64_t b)
+{
+  try
+  {
+    return primecount::count_primes(a, b);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_count_primes: " << e.what() << std::endl;
+    return -1;
+  }
+}
+
 int64_t primecount_nth_prime(int64_t n)
 {
   try
@@ -122,6 +176,31 @@ void primecount_set_num_threads(int threads)
   }
 }
 
+int64_t primecount_get_max_memory(void)
+{
+  try
+  {
+    return primecount::get_max_memory();
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_get_max_memory: " << e.what() << std::endl;
+    return -1;
+  }
+}
+
+void primecount_set_max_memory(int64_t bytes)
+{
+  try
+  {
+    primecount::set_max_memory(bytes);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "primecount_set_max_memory: " << e.what() << std::endl;
+  }
+}
+
 const char* primecount_get_max_x(void)
 {
 #ifdef HAVE_INT128_T
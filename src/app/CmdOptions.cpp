@@ -24,12 +24,18 @@
 #include "CmdOptions.hpp"
 #include <primecount.hpp>
 #include <primecount-internal.hpp>
+#include <backup.hpp>
+#include <cpu_cache.hpp>
+#include <distributed.hpp>
+#include <numa.hpp>
 #include <Vector.hpp>
 #include <print.hpp>
+#include <trace.hpp>
 #include <int128_t.hpp>
 
 #include <stdint.h>
 #include <cstddef>
+#include <limits>
 #include <map>
 #include <string>
 #include <utility>
@@ -214,6 +220,12 @@ void CmdOptions::optionStatus(Option& opt)
     set_status_precision(opt.to<int>());
 }
 
+void CmdOptions::optionJson()
+{
+  set_print_json(true);
+  time = true;
+}
+
 CmdOptions parseOptions(int argc, char* argv[])
 {
   // No command-line options provided
@@ -227,6 +239,9 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--alpha", std::make_pair(OPTION_ALPHA, REQUIRED_PARAM) },
     { "--alpha-y", std::make_pair(OPTION_ALPHA_Y, REQUIRED_PARAM) },
     { "--alpha-z", std::make_pair(OPTION_ALPHA_Z, REQUIRED_PARAM) },
+    { "-b", std::make_pair(OPTION_BACKUP, REQUIRED_PARAM) },
+    { "--backup", std::make_pair(OPTION_BACKUP, REQUIRED_PARAM) },
+    { "--coordinator", std::make_pair(OPTION_COORDINATOR, REQUIRED_PARAM) },
     { "-d", std::make_pair(OPTION_DELEGLISE_RIVAT, NO_PARAM) },
     { "--deleglise-rivat", std::make_pair(OPTION_DELEGLISE_RIVAT, NO_PARAM) },
     { "--deleglise-rivat-64", std::make_pair(OPTION_DELEGLISE_RIVAT_64, NO_PARAM) },
@@ -237,6 +252,10 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--gourdon-128", std::make_pair(OPTION_GOURDON_128, NO_PARAM) },
     { "-h", std::make_pair(OPTION_HELP, NO_PARAM) },
     { "--help", std::make_pair(OPTION_HELP, NO_PARAM) },
+    { "--high", std::make_pair(OPTION_HIGH, REQUIRED_PARAM) },
+    { "--json", std::make_pair(OPTION_JSON, NO_PARAM) },
+    { "--L1d-cache", std::make_pair(OPTION_L1D_CACHE, REQUIRED_PARAM) },
+    { "--L2-cache", std::make_pair(OPTION_L2_CACHE, REQUIRED_PARAM) },
     { "-l", std::make_pair(OPTION_LEGENDRE, NO_PARAM) },
     { "--legendre", std::make_pair(OPTION_LEGENDRE, NO_PARAM) },
     { "--lehmer", std::make_pair(OPTION_LEHMER, NO_PARAM) },
@@ -246,13 +265,17 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--lmo3", std::make_pair(OPTION_LMO3, NO_PARAM) },
     { "--lmo4", std::make_pair(OPTION_LMO4, NO_PARAM) },
     { "--lmo5", std::make_pair(OPTION_LMO5, NO_PARAM) },
+    { "--low", std::make_pair(OPTION_LOW, REQUIRED_PARAM) },
+    { "--max-memory", std::make_pair(OPTION_MAX_MEMORY, REQUIRED_PARAM) },
     { "-m", std::make_pair(OPTION_MEISSEL, NO_PARAM) },
     { "--meissel", std::make_pair(OPTION_MEISSEL, NO_PARAM) },
     { "-n", std::make_pair(OPTION_NTHPRIME, NO_PARAM) },
     { "--nth-prime", std::make_pair(OPTION_NTHPRIME, NO_PARAM) },
     { "--number", std::make_pair(OPTION_NUMBER, REQUIRED_PARAM) },
+    { "--numa", std::make_pair(OPTION_NUMA, OPTIONAL_PARAM) },
     { "-p", std::make_pair(OPTION_PRIMESIEVE, NO_PARAM) },
     { "--primesieve", std::make_pair(OPTION_PRIMESIEVE, NO_PARAM) },
+    { "--profile", std::make_pair(OPTION_PROFILE, REQUIRED_PARAM) },
     { "--Li", std::make_pair(OPTION_LI, NO_PARAM) },
     { "--Li-inverse", std::make_pair(OPTION_LIINV, NO_PARAM) },
     { "-R", std::make_pair(OPTION_R, NO_PARAM) },
@@ -277,12 +300,18 @@ CmdOptions parseOptions(int argc, char* argv[])
     { "--time", std::make_pair(OPTION_TIME, NO_PARAM) },
     { "-t", std::make_pair(OPTION_THREADS, REQUIRED_PARAM) },
     { "--threads", std::make_pair(OPTION_THREADS, REQUIRED_PARAM) },
+    { "--trace", std::make_pair(OPTION_TRACE, REQUIRED_PARAM) },
+    { "--tune", std::make_pair(OPTION_TUNE, NO_PARAM) },
     { "-v", std::make_pair(OPTION_VERSION, NO_PARAM) },
-    { "--version", std::make_pair(OPTION_VERSION, NO_PARAM) }
+    { "--version", std::make_pair(OPTION_VERSION, NO_PARAM) },
+    { "--worker", std::make_pair(OPTION_WORKER, REQUIRED_PARAM) }
   };
 
   CmdOptions opts;
   Vector<maxint_t> numbers;
+  int64_t low = 0;
+  int64_t high = std::numeric_limits<int64_t>::max();
+  bool is_chunk = false;
 
   for (int i = 1; i < argc; i++)
   {
@@ -294,10 +323,22 @@ CmdOptions parseOptions(int argc, char* argv[])
       case OPTION_ALPHA:   set_alpha(opt.to<double>()); break;
       case OPTION_ALPHA_Y: set_alpha_y(opt.to<double>()); break;
       case OPTION_ALPHA_Z: set_alpha_z(opt.to<double>()); break;
+      case OPTION_BACKUP:  set_backup_file(opt.val); break;
+      case OPTION_COORDINATOR: set_coordinator(opt.val); break;
+      case OPTION_WORKER:  set_worker(opt.val); break;
+      case OPTION_LOW:     low = opt.to<int64_t>(); is_chunk = true; break;
+      case OPTION_HIGH:    high = opt.to<int64_t>(); is_chunk = true; break;
+      case OPTION_L1D_CACHE: set_l1d_cache_size(opt.to<int64_t>()); break;
+      case OPTION_L2_CACHE: set_l2_cache_size(opt.to<int64_t>()); break;
+      case OPTION_MAX_MEMORY: set_max_memory(opt.to<int64_t>()); break;
       case OPTION_NUMBER:  numbers.push_back(opt.to<maxint_t>()); break;
+      case OPTION_PROFILE: opts.profile = opt.val; break;
+      case OPTION_NUMA:    set_numa(opt.val.empty() ? 0 : opt.to<int>()); break;
       case OPTION_THREADS: set_num_threads(opt.to<int>()); break;
+      case OPTION_TRACE:   set_trace_file(opt.val); break;
       case OPTION_HELP:    help(/* exitCode */ 0); break;
       case OPTION_STATUS:  opts.optionStatus(opt); break;
+      case OPTION_JSON:    opts.optionJson(); break;
       case OPTION_TIME:    opts.time = true; break;
       case OPTION_TEST:    test(); break;
       case OPTION_VERSION: version(); break;
@@ -312,6 +353,23 @@ CmdOptions parseOptions(int argc, char* argv[])
     opts.a = numbers[1];
   }
 
+  if (is_coordinator() || is_worker())
+  {
+    if (opts.option != OPTION_AC &&
+        opts.option != OPTION_D &&
+        opts.option != OPTION_S2_HARD)
+      throw primecount_error("options --coordinator and --worker require --AC, --D or --S2-hard");
+  }
+
+  if (is_chunk)
+  {
+    if (opts.option != OPTION_AC &&
+        opts.option != OPTION_B &&
+        opts.option != OPTION_D)
+      throw primecount_error("options --low and --high require --AC, --B or --D");
+    set_chunk(low, high);
+  }
+
   if (numbers.empty())
     throw primecount_error("missing x number");
 
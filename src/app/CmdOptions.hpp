@@ -24,6 +24,8 @@ enum OptionID
   OPTION_ALPHA,
   OPTION_ALPHA_Y,
   OPTION_ALPHA_Z,
+  OPTION_BACKUP,
+  OPTION_COORDINATOR,
   OPTION_DEFAULT,
   OPTION_DELEGLISE_RIVAT,
   OPTION_DELEGLISE_RIVAT_64,
@@ -32,6 +34,10 @@ enum OptionID
   OPTION_GOURDON_64,
   OPTION_GOURDON_128,
   OPTION_HELP,
+  OPTION_HIGH,
+  OPTION_JSON,
+  OPTION_L1D_CACHE,
+  OPTION_L2_CACHE,
   OPTION_LEGENDRE,
   OPTION_LEHMER,
   OPTION_LMO,
@@ -40,10 +46,14 @@ enum OptionID
   OPTION_LMO3,
   OPTION_LMO4,
   OPTION_LMO5,
+  OPTION_LOW,
+  OPTION_MAX_MEMORY,
   OPTION_MEISSEL,
   OPTION_NTHPRIME,
+  OPTION_NUMA,
   OPTION_NUMBER,
   OPTION_PRIMESIEVE,
+  OPTION_PROFILE,
   OPTION_LI,
   OPTION_LIINV,
   OPTION_R,
@@ -63,7 +73,10 @@ enum OptionID
   OPTION_TEST,
   OPTION_TIME,
   OPTION_THREADS,
-  OPTION_VERSION
+  OPTION_TRACE,
+  OPTION_TUNE,
+  OPTION_VERSION,
+  OPTION_WORKER
 };
 
 /// Command-line option
@@ -96,6 +109,7 @@ struct CmdOptions
 {
   std::string stressTestMode;
   std::string optionStr;
+  std::string profile;
   int option = OPTION_DEFAULT;
   maxint_t x = -1;
   int64_t a = -1;
@@ -103,6 +117,7 @@ struct CmdOptions
 
   void setMainOption(OptionID optionID, const std::string& optStr);
   void optionStatus(Option& opt);
+  void optionJson();
 };
 
 CmdOptions parseOptions(int, char**);
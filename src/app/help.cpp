@@ -23,17 +23,29 @@ void help(int exitCode)
     "\n"
     "Options:\n"
     "\n"
+    "  -b, --backup=FILE        Periodically store intermediate results in FILE.\n"
+    "                           If FILE exists, resume the computation from FILE.\n"
     "  -d, --deleglise-rivat    Count primes using the Deleglise-Rivat algorithm\n"
     "  -g, --gourdon            Count primes using Xavier Gourdon's algorithm.\n"
     "                           This is the default algorithm.\n"
+    "      --json               Print the parameters, status and results of\n"
+    "                           all formulas as JSON records (one per line)\n"
+    "      --L1d-cache=BYTES    Override the detected L1 data cache size (per core)\n"
+    "      --L2-cache=BYTES     Override the detected L2 cache size (per core)\n"
     "  -l, --legendre           Count primes using Legendre's formula\n"
     "      --lehmer             Count primes using Lehmer's formula\n"
     "      --lmo                Count primes using Lagarias-Miller-Odlyzko\n"
+    "      --max-memory=BYTES   Limit the memory usage of pi(x), e.g. 2^30.\n"
+    "                           Uses smaller caches, tables and fewer threads.\n"
     "  -m, --meissel            Count primes using Meissel's formula\n"
     "      --Li                 Eulerian logarithmic integral function\n"
     "      --Li-inverse         Approximate the nth prime using Li^-1(x)\n"
     "  -n, --nth-prime          Calculate the nth prime\n"
+    "      --numa[=N]           Pin the threads to NUMA nodes and replicate the\n"
+    "                           lookup tables of the D formula on each node.\n"
+    "                           N > 0 simulates N NUMA nodes (for testing).\n"
     "  -p, --primesieve         Count primes using the sieve of Eratosthenes\n"
+    "      --profile=FILE       Alpha tuning profile, default: ~/.primecount_profile\n"
     "      --phi <X> <A>        phi(x, a) counts the numbers <= x that are not\n"
     "                           divisible by any of the first a primes\n"
     "  -R, --RiemannR           Approximate pi(x) using the Riemann R function\n"
@@ -44,6 +56,11 @@ void help(int exitCode)
     "      --time               Print the time elapsed in seconds\n"
     "  -t, --threads=NUM        Set the number of threads, 1 <= NUM <= CPU cores.\n"
     "                           By default primecount uses all available CPU cores.\n"
+    "      --trace=FILE         Write the chunks of work processed by each thread\n"
+    "                           to FILE (CSV or JSON if FILE ends with .json)\n"
+    "      --tune               Measure the fastest alpha tuning factors for\n"
+    "                           10^10, 10^11, ... <= x and store them in the\n"
+    "                           alpha tuning profile\n"
     "  -v, --version            Print version and license information\n"
     "  -h, --help               Print this help menu\n"
     "\n"
@@ -60,11 +77,17 @@ void help(int exitCode)
     "\n"
     "      --alpha-y=NUM        Set tuning factor: y = x^(1/3) * alpha_y\n"
     "      --alpha-z=NUM        Set tuning factor: z = y * alpha_z\n"
+    "      --coordinator=PORT   Assign the work of the AC or D formula to the\n"
+    "                           worker processes that connect to PORT\n"
     "      --AC                 Compute the A + C formulas\n"
     "      --B                  Compute the B formula\n"
     "      --D                  Compute the D formula\n"
+    "      --low=L --high=H     Only compute the part of the AC, B or D formula\n"
+    "                           that corresponds to the sieving interval [L, H[\n"
     "      --Phi0               Compute the Phi0 formula\n"
-    "      --Sigma              Compute the 7 Sigma formulas\n";
+    "      --Sigma              Compute the 7 Sigma formulas\n"
+    "      --worker=HOST:PORT   Compute the AC or D formula using the work\n"
+    "                           assigned by the coordinator process HOST:PORT\n";
 
   std::cout << helpMenu << std::endl;
   std::exit(exitCode);
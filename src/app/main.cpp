@@ -29,8 +29,11 @@
 #include <imath.hpp>
 #include <int128_t.hpp>
 #include <PhiTiny.hpp>
+#include <perf_counters.hpp>
 #include <print.hpp>
 #include <S.hpp>
+#include <trace.hpp>
+#include <tune.hpp>
 
 #include <stdint.h>
 #include <exception>
@@ -357,6 +360,19 @@ int main (int argc, char* argv[])
     auto threads = get_num_threads();
     maxint_t res = 0;
 
+    std::string profile = opts.profile;
+    if (profile.empty())
+      profile = default_tune_profile();
+
+    if (opts.option == OPTION_TUNE)
+    {
+      tune(x, threads, profile);
+      return 0;
+    }
+
+    // Use the machine's alpha tuning profile
+    load_tune_profile(profile);
+
     switch (opts.option)
     {
       case OPTION_DEFAULT:
@@ -429,7 +445,12 @@ int main (int argc, char* argv[])
 #endif
     }
 
-    if (is_print_combined_result())
+    if (is_trace())
+      write_trace();
+
+    if (is_print_json())
+      print_json_result(res, get_time() - time);
+    else if (is_print_combined_result())
     {
       // Add empty line after last partial formula
       if (is_print())
@@ -440,6 +461,9 @@ int main (int argc, char* argv[])
       if (opts.time)
         print_seconds(get_time() - time);
     }
+
+    // WITH_PERF_COUNTERS=ON only
+    print_perf_counters();
   }
   catch (std::exception& e)
   {
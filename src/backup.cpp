@@ -0,0 +1,179 @@
+///
+/// @file  backup.cpp
+/// @brief Functions to load and store the backup file. The backup
+///        file is a plain text file with one "key = value" pair
+///        per line, e.g.:
+///
+///        version = 7.14
+///        D.x = 1000000000000000000000000
+///        D.y = 1386755233
+///        D.low = 123456789
+///        D.sum = 987654321
+///
+///        The keys of each formula are prefixed by the name of the
+///        formula. Before resuming a formula we check that it has
+///        been computed using the same parameters (x, y, z, k).
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <backup.hpp>
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <int128_t.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+std::string backup_file_;
+
+/// Remove leading and trailing whitespace
+std::string trim(const std::string& str)
+{
+  std::string space = " \t\r\n";
+  std::size_t first = str.find_first_not_of(space);
+
+  if (first == std::string::npos)
+    return std::string();
+
+  std::size_t last = str.find_last_not_of(space);
+  return str.substr(first, last - first + 1);
+}
+
+} // namespace
+
+namespace primecount {
+
+void set_backup_file(const std::string& filename)
+{
+  backup_file_ = filename;
+}
+
+const std::string& backup_file()
+{
+  return backup_file_;
+}
+
+/// Nested pi(x) computations (see is_nested())
+/// do not use the backup file.
+///
+bool is_backup()
+{
+  return !backup_file_.empty() &&
+         !is_nested();
+}
+
+/// Backup files created by a different primecount
+/// version are ignored as the computation of the
+/// formulas may have changed in the meantime.
+///
+Backup load_backup()
+{
+  Backup backup;
+  std::ifstream file(backup_file_);
+
+  if (!file)
+    return backup;
+
+  std::string line;
+
+  while (std::getline(file, line))
+  {
+    std::size_t pos = line.find('=');
+
+    if (pos != std::string::npos)
+    {
+      std::string key = trim(line.substr(0, pos));
+      std::string value = trim(line.substr(pos + 1));
+      backup[key] = value;
+    }
+  }
+
+  if (backup["version"] != PRIMECOUNT_VERSION)
+    backup.clear();
+
+  return backup;
+}
+
+/// The backup is first written to a temporary file which
+/// is then renamed. This way the backup file is never
+/// left in a corrupted state if the computer crashes
+/// while writing the backup file.
+///
+void store_backup(const Backup& backup)
+{
+  std::string tmp_file = backup_file_ + ".tmp";
+
+  {
+    std::ofstream file(tmp_file, std::ios::trunc);
+    file << "version = " << PRIMECOUNT_VERSION << '\n';
+
+    for (const auto& entry : backup)
+      if (entry.first != "version")
+        file << entry.first << " = " << entry.second << '\n';
+
+    if (!file.flush())
+      throw primecount_error("failed to write backup file: " + tmp_file);
+  }
+
+  // Windows cannot rename to an existing file
+  if (std::rename(tmp_file.c_str(), backup_file_.c_str()) != 0)
+  {
+    std::remove(backup_file_.c_str());
+    if (std::rename(tmp_file.c_str(), backup_file_.c_str()) != 0)
+      throw primecount_error("failed to write backup file: " + backup_file_);
+  }
+}
+
+/// Returns true if the backup contains the state of
+/// formula computed using the same x, y, z and k.
+///
+bool is_resume(const Backup& backup,
+               const std::string& formula,
+               maxint_t x,
+               int64_t y,
+               int64_t z,
+               int64_t k)
+{
+  auto equals = [&](const std::string& key, const std::string& value) {
+    auto iter = backup.find(formula + "." + key);
+    return iter != backup.end() && iter->second == value;
+  };
+
+  return equals("x", to_string(x)) &&
+         equals("y", std::to_string(y)) &&
+         equals("z", std::to_string(z)) &&
+         equals("k", std::to_string(k));
+}
+
+/// Delete the previous state of formula and
+/// store the parameters of the new computation.
+///
+void reset_backup(Backup& backup,
+                  const std::string& formula,
+                  maxint_t x,
+                  int64_t y,
+                  int64_t z,
+                  int64_t k)
+{
+  std::string prefix = formula + ".";
+  auto iter = backup.lower_bound(prefix);
+
+  while (iter != backup.end() &&
+         iter->first.compare(0, prefix.size(), prefix) == 0)
+    iter = backup.erase(iter);
+
+  backup[prefix + "x"] = to_string(x);
+  backup[prefix + "y"] = std::to_string(y);
+  backup[prefix + "z"] = std::to_string(z);
+  backup[prefix + "k"] = std::to_string(k);
+}
+
+} // namespace
@@ -0,0 +1,239 @@
+///
+/// @file  cpu_cache.cpp
+/// @brief Detect the CPU's L1 data cache and L2 cache sizes at
+///        runtime. On Linux the cache sizes of the 1st CPU core
+///        are read from /sys/devices/system/cpu/cpu0/cache, on
+///        macOS we use sysctlbyname(). Since primecount's load
+///        balancers need the cache size per CPU core, an L2 cache
+///        shared by multiple physical CPU cores is divided by the
+///        number of physical CPU cores sharing it.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <cpu_cache.hpp>
+#include <primecount.hpp>
+#include <primecount-config.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__APPLE__)
+  #include <sys/types.h>
+  #include <sys/sysctl.h>
+#endif
+
+namespace {
+
+/// 0 = use the detected cache size
+int64_t l1d_cache_size_ = 0;
+int64_t l2_cache_size_ = 0;
+
+struct CacheSizes
+{
+  int64_t l1d = 0;
+  int64_t l2 = 0;
+};
+
+/// We don't trust the operating system to
+/// always report sensible cache sizes.
+bool is_valid(int64_t bytes)
+{
+  return bytes >= (1 << 12) &&
+         bytes <= (1 << 30);
+}
+
+#if defined(__linux__)
+
+std::string read_line(const std::string& filename)
+{
+  std::ifstream file(filename);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+/// Parse cache size e.g. "48K", "2048K", "1M"
+int64_t parse_size(const std::string& str)
+{
+  std::size_t pos = 0;
+  int64_t size = std::stoll(str, &pos);
+
+  if (pos < str.size())
+  {
+    if (str[pos] == 'K')
+      size <<= 10;
+    else if (str[pos] == 'M')
+      size <<= 20;
+    else if (str[pos] == 'G')
+      size <<= 30;
+  }
+
+  return size;
+}
+
+/// Count the CPUs of a sysfs CPU list e.g. "0-7,16-23"
+int64_t count_cpus(const std::string& cpulist)
+{
+  int64_t cpus = 0;
+  std::istringstream iss(cpulist);
+  std::string range;
+
+  while (std::getline(iss, range, ','))
+  {
+    std::size_t pos = range.find('-');
+    int64_t first = std::stoll(range.substr(0, pos));
+    int64_t last = (pos == std::string::npos) ? first : std::stoll(range.substr(pos + 1));
+    cpus += last - first + 1;
+  }
+
+  return cpus;
+}
+
+CacheSizes detect_cache_sizes()
+{
+  CacheSizes sizes;
+  std::string cpu0 = "/sys/devices/system/cpu/cpu0";
+
+  // Number of hardware threads per physical CPU core
+  int64_t threads_per_core = 1;
+  std::string siblings = read_line(cpu0 + "/topology/thread_siblings_list");
+  if (!siblings.empty())
+    threads_per_core = std::max<int64_t>(1, count_cpus(siblings));
+
+  for (int i = 0; i <= 3; i++)
+  {
+    std::string path = cpu0 + "/cache/index" + std::to_string(i);
+    std::string level = read_line(path + "/level");
+    std::string type = read_line(path + "/type");
+    std::string size = read_line(path + "/size");
+
+    if (size.empty() ||
+        (type != "Data" && type != "Unified"))
+      continue;
+
+    if (level == "1")
+      sizes.l1d = parse_size(size);
+    else if (level == "2")
+    {
+      sizes.l2 = parse_size(size);
+      std::string shared = read_line(path + "/shared_cpu_list");
+
+      if (!shared.empty())
+      {
+        int64_t cores = count_cpus(shared) / threads_per_core;
+        sizes.l2 /= std::max<int64_t>(1, cores);
+      }
+    }
+  }
+
+  return sizes;
+}
+
+#elif defined(__APPLE__)
+
+int64_t sysctl_value(const char* name)
+{
+  int64_t value = 0;
+  std::size_t size = sizeof(value);
+
+  if (sysctlbyname(name, &value, &size, nullptr, 0) != 0)
+    return 0;
+
+  return value;
+}
+
+CacheSizes detect_cache_sizes()
+{
+  CacheSizes sizes;
+  sizes.l1d = sysctl_value("hw.l1dcachesize");
+  sizes.l2 = sysctl_value("hw.l2cachesize");
+
+  // Apple Silicon CPUs share the L2 cache
+  // between the CPU cores of a cluster.
+  int64_t cores = sysctl_value("hw.perflevel0.cpusperl2");
+  if (cores > 1)
+    sizes.l2 /= cores;
+
+  return sizes;
+}
+
+#else
+
+CacheSizes detect_cache_sizes()
+{
+  return CacheSizes();
+}
+
+#endif
+
+/// The cache sizes are detected only once
+const CacheSizes& cache_sizes()
+{
+  static const CacheSizes sizes = []
+  {
+    CacheSizes detected;
+
+    try {
+      detected = detect_cache_sizes();
+    }
+    catch (std::exception&)
+    {
+      // Fall back to the default cache sizes
+      detected = CacheSizes();
+    }
+
+    CacheSizes sizes;
+    sizes.l1d = is_valid(detected.l1d) ? detected.l1d : L1D_CACHE_SIZE;
+    sizes.l2 = is_valid(detected.l2) ? detected.l2 : L2_CACHE_SIZE;
+    sizes.l2 = std::max(sizes.l2, sizes.l1d);
+    return sizes;
+  }();
+
+  return sizes;
+}
+
+} // namespace
+
+namespace primecount {
+
+int64_t get_l1d_cache_size()
+{
+  if (l1d_cache_size_ > 0)
+    return l1d_cache_size_;
+  else
+    return cache_sizes().l1d;
+}
+
+int64_t get_l2_cache_size()
+{
+  if (l2_cache_size_ > 0)
+    return l2_cache_size_;
+  else
+    return cache_sizes().l2;
+}
+
+void set_l1d_cache_size(int64_t bytes)
+{
+  if (bytes != 0 && !is_valid(bytes))
+    throw primecount_error("invalid L1 data cache size: " + std::to_string(bytes));
+
+  l1d_cache_size_ = bytes;
+}
+
+void set_l2_cache_size(int64_t bytes)
+{
+  if (bytes != 0 && !is_valid(bytes))
+    throw primecount_error("invalid L2 cache size: " + std::to_string(bytes));
+
+  l2_cache_size_ = bytes;
+}
+
+} // namespace
@@ -214,7 +214,7 @@ int64_t S2_easy(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== S2_easy(x, y) ===");
+    print_header("S2_easy(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
@@ -242,7 +242,7 @@ int128_t S2_easy(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== S2_easy(x, y) ===");
+    print_header("S2_easy(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
@@ -29,12 +29,15 @@
 #include <FactorTable.hpp>
 #include <Sieve.hpp>
 #include <fast_div.hpp>
+#include <fast_div_batch.hpp>
 #include <generate_primes.hpp>
 #include <phi_vector.hpp>
 #include <imath.hpp>
 #include <int128_t.hpp>
 #include <LoadBalancerS2.hpp>
+#include <distributed.hpp>
 #include <min.hpp>
+#include <perf_counters.hpp>
 #include <print.hpp>
 #include <S.hpp>
 
@@ -83,6 +86,10 @@ T S2_hard_thread(T x,
   if (min_b > max_b)
     return 0;
 
+  // All x / (prime * m) < limit
+  bool is_div_batch = is_fast_div_batch() &&
+                      limit <= DIV_BATCH_MAX_QUOTIENT;
+
   Vector<int64_t> phi = phi_vector(low, max_b, primes, pi);
   Sieve sieve(low, segment_size, max_b);
   thread.init_finished();
@@ -117,16 +124,22 @@ T S2_hard_thread(T x,
       min_m = factor.to_index(min_m);
       max_m = factor.to_index(max_m);
 
-      for (int64_t m = max_m; m > min_m; m--)
+      if (is_div_batch)
+        sum += leaves_div_batch(xp, phi[b], min_m, max_m, low, factor, sieve,
+                                [&](int64_t m) { return prime < factor.mu_lpf(m); });
+      else
       {
-        // mu(m) != 0 && prime < lpf(m)
-        if (prime < factor.mu_lpf(m))
+        for (int64_t m = max_m; m > min_m; m--)
         {
-          int64_t xpm = fast_div64(xp, factor.to_number(m));
-          int64_t stop = xpm - low;
-          int64_t phi_xpm = phi[b] + sieve.count(stop);
-          int64_t mu_m = factor.mu(m);
-          sum -= mu_m * phi_xpm;
+          // mu(m) != 0 && prime < lpf(m)
+          if (prime < factor.mu_lpf(m))
+          {
+            int64_t xpm = fast_div64(xp, factor.to_number(m));
+            int64_t stop = xpm - low;
+            int64_t phi_xpm = phi[b] + sieve.count(stop);
+            int64_t mu_m = factor.mu(m);
+            sum -= mu_m * phi_xpm;
+          }
         }
       }
 
@@ -150,12 +163,17 @@ T S2_hard_thread(T x,
       if (prime >= primes[l])
         goto next_segment;
 
-      for (; primes[l] > min_hard; l--)
+      if (is_div_batch)
+        sum += leaves_2primes_div_batch(xp, phi[b], l, min_hard, low, primes, sieve);
+      else
       {
-        int64_t xpq = fast_div64(xp, primes[l]);
-        int64_t stop = xpq - low;
-        int64_t phi_xpq = phi[b] + sieve.count(stop);
-        sum += phi_xpq;
+        for (; primes[l] > min_hard; l--)
+        {
+          int64_t xpq = fast_div64(xp, primes[l]);
+          int64_t stop = xpq - low;
+          int64_t phi_xpq = phi[b] + sieve.count(stop);
+          sum += phi_xpq;
+        }
       }
 
       phi[b] += sieve.get_total_count();
@@ -205,6 +223,7 @@ T S2_hard_OpenMP(T x,
   threads = ideal_num_threads(z, threads, thread_threshold);
 
   LoadBalancerS2 loadBalancer(x, z, s2_hard_approx, threads, is_print);
+  loadBalancer.set_formula("S2_hard", y, z, c);
   int64_t max_prime = min(y, z / isqrt(y));
   PiTable pi(max_prime, threads);
 
@@ -219,6 +238,7 @@ T S2_hard_OpenMP(T x,
       using UT = typename pstd::make_unsigned<T>::type;
 
       thread.start_time();
+      PerfCounters perf("S2_hard");
       UT sum = S2_hard_thread((UT) x, y, z, c, primes, pi, factor, thread);
       thread.sum = (T) sum;
       thread.stop_time();
@@ -230,6 +250,26 @@ T S2_hard_OpenMP(T x,
   return sum;
 }
 
+/// The coordinator process only assigns work to the worker
+/// processes (which compute the special leaves) and sums up
+/// their results, hence it needs no lookup tables.
+///
+template <typename T>
+T S2_hard_coordinator(T x,
+                      int64_t y,
+                      int64_t z,
+                      int64_t c,
+                      T s2_hard_approx,
+                      bool is_print)
+{
+  LoadBalancerS2 loadBalancer(x, z, s2_hard_approx, 1, is_print);
+  loadBalancer.set_formula("S2_hard", y, z, c);
+  loadBalancer.serve_workers();
+  T sum = (T) loadBalancer.get_sum();
+
+  return sum;
+}
+
 } // namespace
 
 namespace primecount {
@@ -247,15 +287,22 @@ int64_t S2_hard(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== S2_hard(x, y) ===");
+    print_header("S2_hard(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
 
-  FactorTable<uint16_t> factor(y, threads);
-  int64_t max_prime = min(y, z / isqrt(y));
-  auto primes = generate_primes<uint32_t>(max_prime);
-  int64_t sum = S2_hard_OpenMP(x, y, z, c, s2_hard_approx, primes, factor, threads, is_print);
+  int64_t sum;
+
+  if (is_coordinator())
+    sum = S2_hard_coordinator(x, y, z, c, s2_hard_approx, is_print);
+  else
+  {
+    FactorTable<uint16_t> factor(y, threads);
+    int64_t max_prime = min(y, z / isqrt(y));
+    auto primes = generate_primes<uint32_t>(max_prime);
+    sum = S2_hard_OpenMP(x, y, z, c, s2_hard_approx, primes, factor, threads, is_print);
+  }
 
   if (is_print)
     print("S2_hard", sum, time);
@@ -278,15 +325,17 @@ int128_t S2_hard(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== S2_hard(x, y) ===");
+    print_header("S2_hard(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
 
   int128_t sum;
 
+  if (is_coordinator())
+    sum = S2_hard_coordinator(x, y, z, c, s2_hard_approx, is_print);
   // uses less memory
-  if (y <= FactorTable<uint16_t>::max())
+  else if (y <= FactorTable<uint16_t>::max())
   {
     FactorTable<uint16_t> factor(y, threads);
     int64_t max_prime = min(y, z / isqrt(y));
@@ -104,7 +104,7 @@ int64_t S2_trivial(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== S2_trivial(x, y) ===");
+    print_header("S2_trivial(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
@@ -131,7 +131,7 @@ int128_t S2_trivial(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== S2_trivial(x, y) ===");
+    print_header("S2_trivial(x, y)");
     print_vars(x, y, c, threads);
     time = get_time();
   }
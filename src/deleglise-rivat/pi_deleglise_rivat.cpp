@@ -25,6 +25,7 @@
 #include <PhiTiny.hpp>
 #include <int128_t.hpp>
 #include <macros.hpp>
+#include <max_memory.hpp>
 #include <print.hpp>
 #include <S.hpp>
 
@@ -73,6 +74,7 @@ int64_t pi_deleglise_rivat_64(int64_t x,
   double alpha = get_alpha_deleglise_rivat(x);
   int64_t x13 = iroot<3>(x);
   int64_t y = (int64_t) (x13 * alpha);
+  MaxMemory max_memory(x, y, threads);
   int64_t z = x / y;
   int64_t pi_y = pi_noprint(y, threads);
   int64_t c = PhiTiny::get_c(y);
@@ -80,9 +82,10 @@ int64_t pi_deleglise_rivat_64(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== pi_deleglise_rivat_64(x) ===");
+    print_header("pi_deleglise_rivat_64(x)");
     print("pi(x) = S1 + S2 + pi(y) - 1 - P2");
     print(x, y, z, c, threads);
+    print_max_memory(deleglise_rivat_memory(x, y, threads));
   }
 
   int64_t p2 = P2(x, y, pi_y, threads, is_print);
@@ -92,6 +95,9 @@ int64_t pi_deleglise_rivat_64(int64_t x,
   int64_t phi = s1 + s2;
   int64_t sum = phi + pi_y - 1 - p2;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
@@ -116,6 +122,7 @@ int128_t pi_deleglise_rivat_128(int128_t x,
     throw primecount_error("pi(x): x must be <= " + to_string(limit));
 
   int64_t y = (int64_t) (iroot<3>(x) * alpha);
+  MaxMemory max_memory(x, y, threads);
   int64_t z = (int64_t) (x / y);
   int64_t pi_y = pi_noprint(y, threads);
   int64_t c = PhiTiny::get_c(y);
@@ -123,9 +130,10 @@ int128_t pi_deleglise_rivat_128(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== pi_deleglise_rivat_128(x) ===");
+    print_header("pi_deleglise_rivat_128(x)");
     print("pi(x) = S1 + S2 + pi(y) - 1 - P2");
     print(x, y, z, c, threads);
+    print_max_memory(deleglise_rivat_memory(x, y, threads));
   }
 
   int128_t p2 = P2(x, y, pi_y, threads, is_print);
@@ -135,6 +143,9 @@ int128_t pi_deleglise_rivat_128(int128_t x,
   int128_t phi = s1 + s2;
   int128_t sum = phi + pi_y - 1 - p2;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
@@ -0,0 +1,447 @@
+///
+/// @file  distributed.cpp
+/// @brief Minimal TCP transport used for distributed computing
+///        of the special leaves. For each request the worker opens
+///        a new connection to the coordinator, sends a single line
+///        of text and receives a single line of text. Since the
+///        work is assigned in chunks that take at least a few
+///        milliseconds to compute (and usually much longer) the
+///        overhead of opening a new connection is negligible.
+///
+///        All socket operations time out so that neither a
+///        worker nor the coordinator waits forever for a peer that
+///        has died. The chunks of dead workers are reassigned by
+///        the coordinator (see RemoteChunks).
+///
+///        Distributed computing is currently only supported on
+///        POSIX systems (e.g. Linux, macOS, BSD).
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <distributed.hpp>
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <Vector.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+
+#if !defined(_WIN32)
+  #include <errno.h>
+  #include <netdb.h>
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+  #include <sys/time.h>
+  #include <sys/types.h>
+  #include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+int64_t chunk_low_ = 0;
+int64_t chunk_high_ = std::numeric_limits<int64_t>::max();
+std::string coordinator_port_;
+std::string worker_host_;
+std::string worker_port_;
+
+/// Set to true once this worker process has
+/// successfully connected to the coordinator.
+std::atomic<bool> is_connected_(false);
+
+double connect_secs_ = 3600;
+double io_secs_ = 30;
+double chunk_secs_ = 600;
+
+/// Max length of a request or reply
+const std::size_t max_line_size = 1 << 12;
+
+#if !defined(_WIN32)
+
+/// RAII wrapper for a socket file descriptor
+class Socket
+{
+public:
+  Socket(int fd = -1) : fd_(fd) { }
+  ~Socket() { if (fd_ >= 0) close(fd_); }
+  Socket(const Socket&) = delete;
+  Socket& operator=(const Socket&) = delete;
+  int get() const { return fd_; }
+
+  void reset(int fd)
+  {
+    if (fd_ >= 0)
+      close(fd_);
+    fd_ = fd;
+  }
+
+private:
+  int fd_;
+};
+
+/// Send and receive operations on the socket
+/// fail after io_secs_ seconds of inactivity.
+///
+void set_io_timeout(int fd)
+{
+  timeval tv;
+  tv.tv_sec = (time_t) io_secs_;
+  tv.tv_usec = (suseconds_t) ((io_secs_ - (double) tv.tv_sec) * 1e6);
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+bool write_line(int fd, const std::string& str)
+{
+  std::string line = str + '\n';
+  const char* data = line.data();
+  std::size_t size = line.size();
+
+  while (size > 0)
+  {
+    ssize_t bytes = send(fd, data, size, MSG_NOSIGNAL);
+    if (bytes <= 0)
+      return false;
+    data += bytes;
+    size -= (std::size_t) bytes;
+  }
+
+  return true;
+}
+
+bool read_line(int fd, std::string& line)
+{
+  line.clear();
+  char c;
+
+  while (recv(fd, &c, 1, 0) == 1)
+  {
+    if (c == '\n')
+      return true;
+    if (line.size() >= max_line_size)
+      return false;
+    line += c;
+  }
+
+  return false;
+}
+
+/// Returns a connected socket or -1 if the
+/// coordinator is not listening.
+///
+int connect_coordinator()
+{
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+
+  if (getaddrinfo(worker_host_.c_str(), worker_port_.c_str(), &hints, &result) != 0)
+    throw primecount::primecount_error("failed to resolve coordinator: " + worker_host_);
+
+  int fd = -1;
+
+  for (addrinfo* ai = result; ai; ai = ai->ai_next)
+  {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0)
+      continue;
+    set_io_timeout(fd);
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+      break;
+    close(fd);
+    fd = -1;
+  }
+
+  freeaddrinfo(result);
+  return fd;
+}
+
+#endif
+
+} // namespace
+
+namespace primecount {
+
+/// The segmented sieves require that the start of each
+/// segment is a multiple of 240. Since the chunk bounds
+/// are rounded the same way in all processes, adjacent
+/// chunks still cover the sieving interval exactly.
+///
+void set_chunk(int64_t low, int64_t high)
+{
+  if (low < 0 || low >= high)
+    throw primecount_error("invalid chunk: --low must be >= 0 and < --high");
+
+  chunk_low_ = low - low % 240;
+  chunk_high_ = high;
+
+  if (high < std::numeric_limits<int64_t>::max())
+    chunk_high_ = high - high % 240;
+}
+
+bool is_chunk()
+{
+  return chunk_low_ > 0 ||
+         chunk_high_ < std::numeric_limits<int64_t>::max();
+}
+
+void restrict_to_chunk(int64_t& low, int64_t& high)
+{
+  low = std::max(low, chunk_low_);
+  high = std::min(high, chunk_high_);
+  low = std::min(low, high);
+}
+
+void set_coordinator(const std::string& port)
+{
+  coordinator_port_ = port;
+}
+
+/// @coordinator: host:port
+void set_worker(const std::string& coordinator)
+{
+  std::size_t pos = coordinator.rfind(':');
+
+  if (pos == std::string::npos || pos + 1 == coordinator.size())
+    throw primecount_error("invalid coordinator address (host:port): " + coordinator);
+
+  worker_host_ = coordinator.substr(0, pos);
+  worker_port_ = coordinator.substr(pos + 1);
+
+  // IPv6 address e.g. [::1]:5000
+  if (worker_host_.size() >= 2 &&
+      worker_host_.front() == '[' &&
+      worker_host_.back() == ']')
+    worker_host_ = worker_host_.substr(1, worker_host_.size() - 2);
+}
+
+/// Nested pi(x) computations (see is_nested()) e.g.
+/// inside the B formula are computed locally.
+///
+bool is_coordinator()
+{
+  return !coordinator_port_.empty() &&
+         !is_nested();
+}
+
+bool is_worker()
+{
+  return !worker_port_.empty() &&
+         !is_nested();
+}
+
+void set_distributed_timeouts(double connect_secs,
+                              double io_secs,
+                              double chunk_secs)
+{
+  if (connect_secs <= 0 || io_secs <= 0 || chunk_secs <= 0)
+    throw primecount_error("distributed timeouts must be > 0");
+
+  connect_secs_ = connect_secs;
+  io_secs_ = io_secs;
+  chunk_secs_ = chunk_secs;
+}
+
+void RemoteChunks::assign(const Chunk& chunk)
+{
+  // Chunks near the end of the computation take
+  // much less time than the slowest chunk.
+  double timeout = std::max(chunk_secs_, max_secs_ * 4);
+  assigned_.push_back(Assigned{chunk, get_time() + timeout});
+}
+
+bool RemoteChunks::finish(int64_t low, double secs)
+{
+  max_secs_ = std::max(max_secs_, secs);
+
+  for (Assigned& assigned : assigned_)
+  {
+    if (assigned.chunk.low == low)
+    {
+      assigned = assigned_.back();
+      assigned_.resize(assigned_.size() - 1);
+      return true;
+    }
+  }
+
+  // The worker of an expired chunk is
+  // still alive, but slower than expected.
+  for (Chunk& chunk : expired_)
+  {
+    if (chunk.low == low)
+    {
+      chunk = expired_.back();
+      expired_.resize(expired_.size() - 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool RemoteChunks::get_expired(Chunk& chunk)
+{
+  double time = get_time();
+
+  for (std::size_t i = 0; i < assigned_.size();)
+  {
+    if (assigned_[i].deadline < time)
+    {
+      expired_.push_back(assigned_[i].chunk);
+      assigned_[i] = assigned_.back();
+      assigned_.resize(assigned_.size() - 1);
+    }
+    else
+      i++;
+  }
+
+  if (expired_.empty())
+    return false;
+
+  chunk = expired_.back();
+  expired_.resize(expired_.size() - 1);
+  return true;
+}
+
+bool RemoteChunks::empty() const
+{
+  return assigned_.empty() &&
+         expired_.empty();
+}
+
+#if !defined(_WIN32)
+
+/// Returns an empty string if the coordinator has finished
+/// the computation and exited. If this worker has not yet
+/// connected to the coordinator we wait (at most connect_secs_)
+/// until the coordinator is ready, as e.g. pi(x) first
+/// computes the other formulas.
+///
+std::string send_request(const std::string& request)
+{
+  Socket sock;
+  double time = get_time();
+
+  while (true)
+  {
+    sock.reset(connect_coordinator());
+
+    if (sock.get() >= 0)
+      break;
+    if (is_connected_)
+      return std::string();
+    if (get_time() - time > connect_secs_)
+      throw primecount_error("failed to connect to coordinator " + worker_host_ + ":" + worker_port_);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  is_connected_ = true;
+  std::string reply;
+  errno = 0;
+
+  if (!write_line(sock.get(), request) ||
+      !read_line(sock.get(), reply))
+  {
+    // The coordinator has finished the computation and
+    // closed its socket before accepting our connection.
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+      return std::string();
+
+    throw primecount_error("lost connection to coordinator " + worker_host_ + ":" + worker_port_);
+  }
+
+  return reply;
+}
+
+void serve_requests(const std::function<std::string(const std::string&)>& reply,
+                    const std::function<bool()>& is_finished)
+{
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo* result = nullptr;
+
+  if (getaddrinfo(nullptr, coordinator_port_.c_str(), &hints, &result) != 0)
+    throw primecount_error("invalid coordinator port: " + coordinator_port_);
+
+  Socket server;
+
+  // Prefer an IPv6 socket that also accepts IPv4
+  // connections, so that workers can connect using
+  // either IPv4 or IPv6 addresses.
+  for (int family : { AF_INET6, AF_UNSPEC })
+  {
+    for (addrinfo* ai = result; ai && server.get() < 0; ai = ai->ai_next)
+    {
+      if (family != AF_UNSPEC && ai->ai_family != family)
+        continue;
+
+      server.reset(socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol));
+      if (server.get() < 0)
+        continue;
+
+      int yes = 1;
+      int no = 0;
+      setsockopt(server.get(), SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+      if (ai->ai_family == AF_INET6)
+        setsockopt(server.get(), IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no));
+
+      if (bind(server.get(), ai->ai_addr, ai->ai_addrlen) != 0 ||
+          listen(server.get(), SOMAXCONN) != 0)
+        server.reset(-1);
+    }
+  }
+
+  freeaddrinfo(result);
+
+  if (server.get() < 0)
+    throw primecount_error("failed to listen on port: " + coordinator_port_);
+
+  while (!is_finished())
+  {
+    Socket client(accept(server.get(), nullptr, nullptr));
+    std::string request;
+
+    if (client.get() < 0)
+      continue;
+
+    // Ignore workers that disconnect prematurely
+    // or that do not send their request in time.
+    set_io_timeout(client.get());
+    if (read_line(client.get(), request))
+      write_line(client.get(), reply(request));
+  }
+}
+
+#else
+
+std::string send_request(const std::string&)
+{
+  throw primecount_error("distributed computing is not supported on Windows");
+}
+
+void serve_requests(const std::function<std::string(const std::string&)>&,
+                    const std::function<bool()>&)
+{
+  throw primecount_error("distributed computing is not supported on Windows");
+}
+
+#endif
+
+} // namespace
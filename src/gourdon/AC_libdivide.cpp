@@ -35,18 +35,21 @@
 #include <SegmentedPiTable.hpp>
 #include <primecount-internal.hpp>
 #include <LoadBalancerAC.hpp>
+#include <distributed.hpp>
 #include <fast_div.hpp>
 #include <generate_primes.hpp>
 #include <gourdon.hpp>
 #include <int128_t.hpp>
 #include <libdivide.h>
 #include <min.hpp>
+#include <perf_counters.hpp>
 #include <imath.hpp>
 #include <Vector.hpp>
 #include <print.hpp>
 #include <RelaxedAtomic.hpp>
 
 #include <stdint.h>
+#include <cstddef>
 
 using namespace primecount;
 
@@ -311,8 +314,8 @@ T AC_OpenMP(T x,
             int64_t z,
             int64_t k,
             int64_t x_star,
-            int64_t max_a_prime,
             const Primes& primes,
+            const PiTable& pi,
             int threads,
             bool is_print)
 {
@@ -328,7 +331,16 @@ T AC_OpenMP(T x,
   int max_threads = (int) std::pow(xz, 1 / 3.7);
   threads = min(threads, max_threads);
   threads = ideal_num_threads(x13, threads, thread_threshold);
-  LoadBalancerAC loadBalancer(sqrtx, y, threads, is_print);
+  LoadBalancerAC loadBalancer(x, sqrtx, y, z, k, threads, is_print);
+
+  // --low=L --high=H: only compute the segments
+  // inside [L, H[, C1 is part of the first chunk.
+  int64_t start = 0;
+  int64_t sieve_limit = sqrtx;
+  restrict_to_chunk(start, sieve_limit);
+  loadBalancer.set_interval(start, sieve_limit);
+  bool is_c1 = !is_worker() && start == 0;
+  bool is_c2 = !is_coordinator();
 
   // Initialize libdivide vector from primes vector
   Vector<libdivide::branchfree_divider<uint64_t>> lprimes;
@@ -336,12 +348,6 @@ T AC_OpenMP(T x,
   for (std::size_t i = 1; i < lprimes.size(); i++)
     lprimes[i] = primes[i];
 
-  // PiTable's size = z because of the C1 formula.
-  // PiTable is accessed much less frequently than
-  // SegmentedPiTable, hence it is OK that PiTable's size
-  // is fairly large and does not fit into the CPU's cache.
-  PiTable pi(max(z, max_a_prime), threads);
-
   int64_t pi_y = pi[y];
   int64_t pi_sqrtz = pi[isqrt(z)];
   int64_t pi_root3_xy = pi[iroot<3>(xy)];
@@ -356,21 +362,30 @@ T AC_OpenMP(T x,
   // 2) Computation of the C2 formula.
   // 3) Computation of the A formula.
   //
+  // In distributed mode the coordinator process computes
+  // the C1 formula whereas the worker processes compute
+  // the C2 and A formulas.
+  //
   #pragma omp parallel num_threads(threads) reduction(+: sum)
   {
     // C1 formula: pi[(x/z)^(1/3)] < b <= pi[pi_sqrtz]
     // There are very few iterations in this loop,
     // hence the use of an atomic loop counter (min_c1)
     // won't cause any scaling issues.
-    for (int64_t b = min_c1++; b <= pi_sqrtz; b = min_c1++)
+    if (is_c1)
     {
-      int64_t prime = primes[b];
-      T xp = x / prime;
-      int64_t max_m = min(xp / prime, z);
-      T min_m128 = max(xp / (prime * prime), z / prime);
-      int64_t min_m = min(min_m128, max_m);
+      PerfCounters perf("C1");
+
+      for (int64_t b = min_c1++; b <= pi_sqrtz; b = min_c1++)
+      {
+        int64_t prime = primes[b];
+        T xp = x / prime;
+        int64_t max_m = min(xp / prime, z);
+        T min_m128 = max(xp / (prime * prime), z / prime);
+        int64_t min_m = min(min_m128, max_m);
 
-      sum -= C1<-1>(xp, b, b, pi_y, 1, min_m, max_m, primes, pi);
+        sum -= C1<-1>(xp, b, b, pi_y, 1, min_m, max_m, primes, pi);
+      }
     }
 
     // SegmentedPiTable is accessed very frequently.
@@ -381,18 +396,19 @@ T AC_OpenMP(T x,
     ThreadDataAC thread;
 
     // for (low = 0; low < sqrt(x); low += segment_size)
-    while (loadBalancer.get_work(thread))
+    while (is_c2 && loadBalancer.get_work(thread))
     {
+      T thread_sum = 0;
       int64_t low = thread.low;
       int64_t segment_size = thread.segment_size;
       int64_t limit = low + thread.segments * segment_size;
-      limit = min(limit, sqrtx);
+      limit = min(limit, sieve_limit);
 
       for (; low < limit; low += segment_size)
       {
         // Current segment [low, high[
         int64_t high = low + segment_size;
-        high = min(high, sqrtx);
+        high = min(high, sieve_limit);
         segmentedPi.init(low, high);
 
         // We measure the thread computation time excluding the
@@ -423,32 +439,47 @@ T AC_OpenMP(T x,
         int64_t max_a = pi[min(sqrt_xlow, x13)];
 
         // C2 formula: pi[sqrt(z)] < b <= pi[x_star]
-        for (int64_t b = min_c2; b <= max_c2; b++)
         {
-          int64_t prime = primes[b];
-          T xp = x / prime;
-
-          if (xp <= pstd::numeric_limits<uint64_t>::max())
-            sum += C2_64(xlow, xhigh, (uint64_t) xp, y, b, prime, lprimes, pi, segmentedPi);
-          else
-            sum += C2_128(xlow, xhigh, xp, y, b, primes, pi, segmentedPi);
+          PerfCounters perf("C2");
+          for (int64_t b = min_c2; b <= max_c2; b++)
+          {
+            int64_t prime = primes[b];
+            T xp = x / prime;
+
+            if (xp <= pstd::numeric_limits<uint64_t>::max())
+              thread_sum += C2_64(xlow, xhigh, (uint64_t) xp, y, b, prime, lprimes, pi, segmentedPi);
+            else
+              thread_sum += C2_128(xlow, xhigh, xp, y, b, primes, pi, segmentedPi);
+          }
         }
 
         // A formula: pi[x_star] < b <= pi[x13]
-        for (int64_t b = min_a; b <= max_a; b++)
         {
-          int64_t prime = primes[b];
-          T xp = x / prime;
-
-          if (xp <= pstd::numeric_limits<uint64_t>::max())
-            sum += A_64(xlow, xhigh, (uint64_t) xp, y, prime, lprimes, pi, segmentedPi);
-          else
-            sum += A_128(xlow, xhigh, xp, y, prime, primes, pi, segmentedPi);
+          PerfCounters perf("A");
+          for (int64_t b = min_a; b <= max_a; b++)
+          {
+            int64_t prime = primes[b];
+            T xp = x / prime;
+
+            if (xp <= pstd::numeric_limits<uint64_t>::max())
+              thread_sum += A_64(xlow, xhigh, (uint64_t) xp, y, prime, lprimes, pi, segmentedPi);
+            else
+              thread_sum += A_128(xlow, xhigh, xp, y, prime, primes, pi, segmentedPi);
+          }
         }
       }
+
+      thread.sum = (maxint_t) thread_sum;
     }
   }
 
+  // In distributed mode the coordinator also
+  // adds up the sums of the worker processes.
+  if (!is_c2)
+    loadBalancer.serve_workers();
+
+  sum += (T) loadBalancer.get_sum();
+
   return sum;
 }
 
@@ -468,7 +499,7 @@ int64_t AC(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== AC(x, y) ===");
+    print_header("AC(x, y)");
     print_gourdon_vars(x, y, z, k, threads);
     time = get_time();
   }
@@ -479,7 +510,13 @@ int64_t AC(int64_t x,
   int64_t max_prime = max(max_a_prime, max_c_prime);
   auto primes = generate_primes<uint32_t>(max_prime);
 
-  int64_t sum = AC_OpenMP((uint64_t) x, y, z, k, x_star, max_a_prime, primes, threads, is_print);
+  // PiTable's size = z because of the C1 formula.
+  // PiTable is accessed much less frequently than
+  // SegmentedPiTable, hence it is OK that PiTable's size
+  // is fairly large and does not fit into the CPU's cache.
+  PiTable pi(max(z, max_a_prime), threads);
+
+  int64_t sum = AC_OpenMP((uint64_t) x, y, z, k, x_star, primes, pi, threads, is_print);
 
   if (is_print)
     print("A + C", sum, time);
@@ -487,6 +524,58 @@ int64_t AC(int64_t x,
   return sum;
 }
 
+/// Compute A + C for multiple x that share the same y, z
+/// and k. The primes and the PiTable are initialized only
+/// once, using the largest bounds of all x.
+///
+Vector<int64_t> AC(const Vector<int64_t>& x,
+                   int64_t y,
+                   int64_t z,
+                   int64_t k,
+                   int threads,
+                   bool is_print)
+{
+  Vector<int64_t> sums(x.size());
+
+  if (x.empty())
+    return sums;
+
+  int64_t max_prime = y;
+  int64_t max_pi = z;
+
+  for (int64_t n : x)
+  {
+    int64_t x_star = get_x_star_gourdon(n, y);
+    int64_t max_a_prime = (int64_t) isqrt(n / x_star);
+    max_prime = max(max_prime, max_a_prime);
+    max_pi = max(max_pi, max_a_prime);
+  }
+
+  auto primes = generate_primes<uint32_t>(max_prime);
+  PiTable pi(max_pi, threads);
+
+  for (std::size_t i = 0; i < x.size(); i++)
+  {
+    double time;
+
+    if (is_print)
+    {
+      print("");
+      print_header("AC(x, y)");
+      print_gourdon_vars(x[i], y, z, k, threads);
+      time = get_time();
+    }
+
+    int64_t x_star = get_x_star_gourdon(x[i], y);
+    sums[i] = AC_OpenMP((uint64_t) x[i], y, z, k, x_star, primes, pi, threads, is_print);
+
+    if (is_print)
+      print("A + C", sums[i], time);
+  }
+
+  return sums;
+}
+
 #ifdef HAVE_INT128_T
 
 int128_t AC(int128_t x,
@@ -501,7 +590,7 @@ int128_t AC(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== AC(x, y) ===");
+    print_header("AC(x, y)");
     print_gourdon_vars(x, y, z, k, threads);
     time = get_time();
   }
@@ -512,16 +601,22 @@ int128_t AC(int128_t x,
   int64_t max_prime = max(max_a_prime, max_c_prime);
   int128_t sum;
 
+  // PiTable's size = z because of the C1 formula.
+  // PiTable is accessed much less frequently than
+  // SegmentedPiTable, hence it is OK that PiTable's size
+  // is fairly large and does not fit into the CPU's cache.
+  PiTable pi(max(z, max_a_prime), threads);
+
   // uses less memory
   if (max_prime <= pstd::numeric_limits<uint32_t>::max())
   {
     auto primes = generate_primes<uint32_t>(max_prime);
-    sum = AC_OpenMP((uint128_t) x, y, z, k, x_star, max_a_prime, primes, threads, is_print);
+    sum = AC_OpenMP((uint128_t) x, y, z, k, x_star, primes, pi, threads, is_print);
   }
   else
   {
     auto primes = generate_primes<uint64_t>(max_prime);
-    sum = AC_OpenMP((uint128_t) x, y, z, k, x_star, max_a_prime, primes, threads, is_print);
+    sum = AC_OpenMP((uint128_t) x, y, z, k, x_star, primes, pi, threads, is_print);
   }
 
   if (is_print)
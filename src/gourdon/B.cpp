@@ -21,8 +21,10 @@
 #include <primesieve.hpp>
 #include <int128_t.hpp>
 #include <LoadBalancerP2.hpp>
+#include <distributed.hpp>
 #include <macros.hpp>
 #include <min.hpp>
+#include <perf_counters.hpp>
 #include <imath.hpp>
 #include <print.hpp>
 
@@ -94,8 +96,14 @@ T B_OpenMP(T x,
     return 0;
 
   T sum = 0;
+  int64_t sqrtx = isqrt(x);
   int64_t xy = (int64_t)(x / max(y, 1));
-  LoadBalancerP2 loadBalancer(x, xy, threads, is_print);
+
+  // --low=L --high=H: only sieve [L, H[
+  int64_t start = sqrtx;
+  int64_t sieve_limit = xy;
+  restrict_to_chunk(start, sieve_limit);
+  LoadBalancerP2 loadBalancer(x, start, sieve_limit, threads, is_print);
   threads = loadBalancer.get_threads();
 
   // for (low = sqrt(x); low < x / y; low += dist)
@@ -103,9 +111,14 @@ T B_OpenMP(T x,
   {
     int64_t low, high;
     while (loadBalancer.get_work(low, high))
+    {
+      PerfCounters perf("B");
       sum += B_thread(x, y, low, high);
+    }
   }
 
+  loadBalancer.check_cancelled();
+
   return sum;
 }
 
@@ -123,7 +136,7 @@ int64_t B(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== B(x, y) ===");
+    print_header("B(x, y)");
     print_gourdon_vars(x, y, threads);
     time = get_time();
   }
@@ -148,7 +161,7 @@ int128_t B(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== B(x, y) ===");
+    print_header("B(x, y)");
     print_gourdon_vars(x, y, threads);
     time = get_time();
   }
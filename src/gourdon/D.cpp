@@ -26,16 +26,25 @@
 #include <PiTable.hpp>
 #include <Sieve.hpp>
 #include <LoadBalancerS2.hpp>
+#include <backup.hpp>
+#include <distributed.hpp>
 #include <fast_div.hpp>
+#include <fast_div_batch.hpp>
 #include <generate_primes.hpp>
 #include <phi_vector.hpp>
 #include <gourdon.hpp>
 #include <imath.hpp>
 #include <int128_t.hpp>
+#include <max_memory.hpp>
 #include <min.hpp>
+#include <numa.hpp>
+#include <perf_counters.hpp>
 #include <print.hpp>
+#include <Vector.hpp>
 
 #include <stdint.h>
+#include <algorithm>
+#include <cstddef>
 
 using namespace primecount;
 
@@ -49,6 +58,7 @@ template <typename T, typename Primes, typename FactorTableD>
 T D_thread(T x,
            int64_t x_star,
            int64_t xz,
+           int64_t sieve_limit,
            int64_t y,
            int64_t z,
            int64_t k,
@@ -64,7 +74,7 @@ T D_thread(T x,
   int64_t segments = thread.segments;
   int64_t segment_size = thread.segment_size;
   int64_t pi_sqrtz = pi[isqrt(z)];
-  int64_t limit = min(low + segments * segment_size, xz);
+  int64_t limit = min(low + segments * segment_size, sieve_limit);
   int64_t max_b = pi[min3(isqrt(x / low1), isqrt(limit), x_star)];
   int64_t min_b = pi[min(xz / limit, x_star)];
   min_b = max(k, min_b) + 1;
@@ -72,6 +82,10 @@ T D_thread(T x,
   if (min_b > max_b)
     return 0;
 
+  // All x / (prime * m) < limit
+  bool is_div_batch = is_fast_div_batch() &&
+                      limit <= DIV_BATCH_MAX_QUOTIENT;
+
   Vector<int64_t> phi = phi_vector(low, max_b, primes, pi);
   Sieve sieve(low, segment_size, max_b);
   thread.init_finished();
@@ -104,21 +118,30 @@ T D_thread(T x,
       if (prime >= max_m)
         goto next_segment;
 
-      min_m = factor.to_index(min_m);
-      max_m = factor.to_index(max_m);
+      // Segmented FactorTableD: only the leaves with
+      // factor.low() <= m <= factor.high()
+      min_m = max(factor.to_index(min_m), factor.first_index() - 1);
+      max_m = min(factor.to_index(max_m), factor.last_index());
+      int64_t leaf_bound = factor.leaf_bound(b);
 
-      for (int64_t m = max_m; m > min_m; m--)
+      if (is_div_batch)
+        sum += leaves_div_batch(xp, phi[b], min_m, max_m, low, factor, sieve,
+                                [&](int64_t m) { return leaf_bound < factor.is_leaf(m); });
+      else
       {
-        // mu[m] != 0 && 
-        // lpf[m] > prime &&
-        // mpf[m] <= y
-        if (prime < factor.is_leaf(m))
+        for (int64_t m = max_m; m > min_m; m--)
         {
-          int64_t xpm = fast_div64(xp, factor.to_number(m));
-          int64_t stop = xpm - low;
-          int64_t phi_xpm = phi[b] + sieve.count(stop);
-          int64_t mu_m = factor.mu(m);
-          sum -= mu_m * phi_xpm;
+          // mu[m] != 0 && 
+          // lpf[m] > prime &&
+          // mpf[m] <= y
+          if (leaf_bound < factor.is_leaf(m))
+          {
+            int64_t xpm = fast_div64(xp, factor.to_number(m));
+            int64_t stop = xpm - low;
+            int64_t phi_xpm = phi[b] + sieve.count(stop);
+            int64_t mu_m = factor.mu(m);
+            sum -= mu_m * phi_xpm;
+          }
         }
       }
 
@@ -143,12 +166,23 @@ T D_thread(T x,
       if (prime >= primes[l])
         goto next_segment;
 
-      for (; primes[l] > min_m; l--)
+      // Segmented FactorTableD: only the leaves with
+      // factor.low() <= primes[l] <= factor.high()
+      if (max_m > factor.high())
+        l = pi[factor.high()];
+      min_m = max(min_m, factor.low() - 1);
+
+      if (is_div_batch)
+        sum += leaves_2primes_div_batch(xp, phi[b], l, min_m, low, primes, sieve);
+      else
       {
-        int64_t xpq = fast_div64(xp, primes[l]);
-        int64_t stop = xpq - low;
-        int64_t phi_xpq = phi[b] + sieve.count(stop);
-        sum += phi_xpq;
+        for (; primes[l] > min_m; l--)
+        {
+          int64_t xpq = fast_div64(xp, primes[l]);
+          int64_t stop = xpq - low;
+          int64_t phi_xpq = phi[b] + sieve.count(stop);
+          sum += phi_xpq;
+        }
       }
 
       phi[b] += sieve.get_total_count();
@@ -186,9 +220,12 @@ T D_OpenMP(T x,
            int64_t k,
            T d_approx,
            const Primes& primes,
+           const PiTable& pi,
            const FactorTableD& factor,
            int threads,
-           bool is_print)
+           bool is_print,
+           int64_t pass = 0,
+           int64_t passes = 1)
 {
   int64_t xz = x / z;
   int64_t x_star = get_x_star_gourdon(x, y);
@@ -200,10 +237,25 @@ T D_OpenMP(T x,
   threads = std::min(threads, max_threads);
   threads = ideal_num_threads(xz, threads, thread_threshold);
   LoadBalancerS2 loadBalancer(x, xz, d_approx, threads, is_print);
-  PiTable pi(y, threads);
+  loadBalancer.set_pass(pass, passes);
+
+  // --low=L --high=H: only sieve [L, H[
+  int64_t start = 0;
+  int64_t sieve_limit = xz;
+  restrict_to_chunk(start, sieve_limit);
+  loadBalancer.set_interval(start, sieve_limit);
+  loadBalancer.set_formula("D", y, z, k);
+
+  // --numa: each NUMA node uses its own copy
+  // of the read-only lookup tables.
+  NumaReplicas<PiTable> pi_replicas(pi);
+  NumaReplicas<FactorTableD> factor_replicas(factor);
 
   #pragma omp parallel num_threads(threads)
   {
+    NumaThread numaThread(threads);
+    const PiTable& pi_node = pi_replicas.get(numaThread.node());
+    const FactorTableD& factor_node = factor_replicas.get(numaThread.node());
     ThreadData thread;
 
     while (loadBalancer.get_work(thread))
@@ -213,7 +265,8 @@ T D_OpenMP(T x,
       using UT = typename pstd::make_unsigned<T>::type;
 
       thread.start_time();
-      UT sum = D_thread((UT) x, x_star, xz, y, z, k, primes, pi, factor, thread);
+      PerfCounters perf("D");
+      UT sum = D_thread((UT) x, x_star, xz, sieve_limit, y, z, k, primes, pi_node, factor_node, thread);
       thread.sum = (T) sum;
       thread.stop_time();
     }
@@ -224,6 +277,337 @@ T D_OpenMP(T x,
   return sum;
 }
 
+/// Compute the contribution of the hard special leaves of
+/// multiple x that share the same y, z and k using a single
+/// segmented sieve. The sieving and the phi(x, a) lookup table
+/// are shared by all x, only the special leaves are computed
+/// separately for each x. The special leaves of x[i] inside
+/// the current segment are added to sums[i].
+///
+template <typename T, typename Primes, typename FactorTableD>
+void D_thread_batch(const Vector<T>& x,
+                    const Vector<int64_t>& x_star,
+                    int64_t sieve_limit,
+                    int64_t y,
+                    int64_t z,
+                    int64_t k,
+                    const Primes& primes,
+                    const PiTable& pi,
+                    const FactorTableD& factor,
+                    Vector<T>& sums,
+                    ThreadData& thread)
+{
+  std::size_t n = x.size();
+  int64_t low = thread.low;
+  int64_t low1 = max(low, 1);
+  int64_t segments = thread.segments;
+  int64_t segment_size = thread.segment_size;
+  int64_t pi_sqrtz = pi[isqrt(z)];
+  int64_t limit = min(low + segments * segment_size, sieve_limit);
+  int64_t min_b = pstd::numeric_limits<int64_t>::max();
+  int64_t max_b = 0;
+  Vector<int64_t> min_bs(n);
+  Vector<int64_t> max_bs(n);
+  Vector<char> is_done(n);
+
+  for (std::size_t i = 0; i < n; i++)
+  {
+    int64_t xz = x[i] / z;
+    max_bs[i] = pi[min3(isqrt(x[i] / low1), isqrt(limit), x_star[i])];
+    min_bs[i] = pi[min(xz / limit, x_star[i])];
+    min_bs[i] = max(k, min_bs[i]) + 1;
+    min_b = min(min_b, min_bs[i]);
+    max_b = max(max_b, max_bs[i]);
+  }
+
+  if (min_b > max_b)
+    return;
+
+  // All x / (prime * m) < limit
+  bool is_div_batch = is_fast_div_batch() &&
+                      limit <= DIV_BATCH_MAX_QUOTIENT;
+
+  Vector<int64_t> phi = phi_vector(low, max_b, primes, pi);
+  Sieve sieve(low, segment_size, max_b);
+  thread.init_finished();
+
+  // Segmented sieve of Eratosthenes
+  for (; low < limit; low += segment_size)
+  {
+    // current segment [low, high[
+    int64_t high = min(low + segment_size, limit);
+    low1 = max(low, 1);
+    std::size_t active = n;
+    std::fill_n(is_done.begin(), n, 0);
+
+    // For b < min_b there are no special leaves:
+    // low <= x / (primes[b] * m) < high
+    sieve.pre_sieve(primes, min_b - 1, low, high);
+    int64_t b = min_b;
+
+    // For k + 1 <= b <= pi_sqrtz
+    // Find all special leaves in the current segment that are
+    // composed of a prime and a square free number:
+    // low <= x / (primes[b] * m) < high
+    for (int64_t last = min(pi_sqrtz, max_b); b <= last; b++)
+    {
+      int64_t prime = primes[b];
+      int64_t leaf_bound = factor.leaf_bound(b);
+
+      for (std::size_t i = 0; i < n; i++)
+      {
+        if (is_done[i] || b < min_bs[i])
+          continue;
+
+        T xp = x[i] / prime;
+        int64_t xp_low = min(fast_div(xp, low1), z);
+        int64_t xp_high = min(fast_div(xp, high), z);
+        int64_t min_m = max(xp_high, z / prime);
+        int64_t max_m = min(fast_div(xp, prime * prime), xp_low);
+
+        if (b > max_bs[i] || prime >= max_m)
+        {
+          is_done[i] = 1;
+          active--;
+          continue;
+        }
+
+        min_m = factor.to_index(min_m);
+        max_m = factor.to_index(max_m);
+        sieve.reset_counter();
+
+        if (is_div_batch)
+          sums[i] += leaves_div_batch(xp, phi[b], min_m, max_m, low, factor, sieve,
+                                      [&](int64_t m) { return leaf_bound < factor.is_leaf(m); });
+        else
+        {
+          for (int64_t m = max_m; m > min_m; m--)
+          {
+            // mu[m] != 0 && 
+            // lpf[m] > prime &&
+            // mpf[m] <= y
+            if (leaf_bound < factor.is_leaf(m))
+            {
+              int64_t xpm = fast_div64(xp, factor.to_number(m));
+              int64_t stop = xpm - low;
+              int64_t phi_xpm = phi[b] + sieve.count(stop);
+              int64_t mu_m = factor.mu(m);
+              sums[i] -= mu_m * phi_xpm;
+            }
+          }
+        }
+      }
+
+      if (active == 0)
+        goto next_segment;
+
+      phi[b] += sieve.get_total_count();
+      sieve.cross_off_count(prime, b);
+    }
+
+    // For pi_sqrtz < b <= pi_x_star
+    // Find all special leaves in the current segment
+    // that are composed of 2 primes:
+    // low <= x / (primes[b] * primes[l]) < high
+    for (; b <= max_b; b++)
+    {
+      int64_t prime = primes[b];
+
+      for (std::size_t i = 0; i < n; i++)
+      {
+        if (is_done[i] || b < min_bs[i])
+          continue;
+
+        T xp = x[i] / prime;
+        int64_t xp_low = min(fast_div(xp, low1), y);
+        int64_t xp_high = min(fast_div(xp, high), y);
+        int64_t min_m = max(xp_high, prime);
+        int64_t max_m = min(fast_div(xp, prime * prime), xp_low);
+        int64_t l = pi[max_m];
+
+        if (b > max_bs[i] || prime >= primes[l])
+        {
+          is_done[i] = 1;
+          active--;
+          continue;
+        }
+
+        sieve.reset_counter();
+
+        if (is_div_batch)
+          sums[i] += leaves_2primes_div_batch(xp, phi[b], l, min_m, low, primes, sieve);
+        else
+        {
+          for (; primes[l] > min_m; l--)
+          {
+            int64_t xpq = fast_div64(xp, primes[l]);
+            int64_t stop = xpq - low;
+            int64_t phi_xpq = phi[b] + sieve.count(stop);
+            sums[i] += phi_xpq;
+          }
+        }
+      }
+
+      if (active == 0)
+        goto next_segment;
+
+      phi[b] += sieve.get_total_count();
+      sieve.cross_off_count(prime, b);
+    }
+
+    next_segment:;
+  }
+}
+
+/// Compute D(x, y) for multiple x that share the same
+/// y, z and k in a single pass over the sieving interval
+/// [0, max(x) / z[. The load balancer and its status
+/// output use the largest x.
+/// @pre x is sorted in ascending order.
+///
+template <typename Primes, typename FactorTableD>
+Vector<int64_t> D_OpenMP_batch(const Vector<int64_t>& x,
+                               int64_t y,
+                               int64_t z,
+                               int64_t k,
+                               int64_t d_approx,
+                               const Primes& primes,
+                               const PiTable& pi,
+                               const FactorTableD& factor,
+                               int threads,
+                               bool is_print)
+{
+  std::size_t n = x.size();
+  int64_t max_x = x[n - 1];
+  int64_t xz = max_x / z;
+  Vector<uint64_t> ux(n);
+  Vector<int64_t> x_star(n);
+  Vector<uint64_t> sums(n);
+  std::fill_n(sums.begin(), n, 0);
+
+  for (std::size_t i = 0; i < n; i++)
+  {
+    ux[i] = (uint64_t) x[i];
+    x_star[i] = get_x_star_gourdon(x[i], y);
+  }
+
+  // These load balancing settings work well on my
+  // dual-socket AMD EPYC 7642 server with 192 CPU cores.
+  int64_t thread_threshold = 1 << 20;
+  int max_threads = (int) std::pow(xz, 1 / 3.7);
+  threads = std::min(threads, max_threads);
+  threads = ideal_num_threads(xz, threads, thread_threshold);
+  LoadBalancerS2 loadBalancer(max_x, xz, d_approx, threads, is_print);
+  NumaReplicas<PiTable> pi_replicas(pi);
+  NumaReplicas<FactorTableD> factor_replicas(factor);
+
+  #pragma omp parallel num_threads(threads)
+  {
+    NumaThread numaThread(threads);
+    const PiTable& pi_node = pi_replicas.get(numaThread.node());
+    const FactorTableD& factor_node = factor_replicas.get(numaThread.node());
+    ThreadData thread;
+    Vector<uint64_t> thread_sums(n);
+
+    while (loadBalancer.get_work(thread))
+    {
+      // Unsigned integer division is usually slightly
+      // faster than signed integer division
+      std::fill_n(thread_sums.begin(), n, 0);
+      thread.start_time();
+      PerfCounters perf("D");
+      D_thread_batch(ux, x_star, xz, y, z, k, primes, pi_node, factor_node, thread_sums, thread);
+      thread.sum = (int64_t) thread_sums[n - 1];
+      thread.stop_time();
+
+      #pragma omp critical (D_batch)
+      for (std::size_t i = 0; i < n; i++)
+        sums[i] += thread_sums[i];
+    }
+  }
+
+  Vector<int64_t> res(n);
+  for (std::size_t i = 0; i < n; i++)
+    res[i] = (int64_t) sums[i];
+
+  return res;
+}
+
+/// The coordinator process only assigns work to the worker
+/// processes (which compute the special leaves) and sums up
+/// their results, hence it needs no lookup tables.
+///
+template <typename T>
+T D_coordinator(T x,
+                int64_t y,
+                int64_t z,
+                int64_t k,
+                T d_approx,
+                bool is_print)
+{
+  int64_t xz = x / z;
+  int64_t start = 0;
+  int64_t sieve_limit = xz;
+  restrict_to_chunk(start, sieve_limit);
+  LoadBalancerS2 loadBalancer(x, xz, d_approx, 1, is_print);
+  loadBalancer.set_interval(start, sieve_limit);
+  loadBalancer.set_formula("D", y, z, k);
+  loadBalancer.serve_workers();
+  T sum = (T) loadBalancer.get_sum();
+
+  return sum;
+}
+
+/// Segmented FactorTableD mode, uses less memory. The
+/// FactorTableD is split into get_factor_table_segments()
+/// segments (more if required by --max-memory)
+/// [low, high] of [1, z] and D(x, y) is computed
+/// once for each segment using only the special leaves
+/// x / (prime * m) with low <= m <= high. Hence only one
+/// segment of the FactorTableD is in memory at any time,
+/// but we need to sieve the interval [0, x / z[ once for
+/// each segment.
+///
+template <typename FactorTableD, typename T, typename Primes>
+T D_OpenMP_segmented(T x,
+                     int64_t y,
+                     int64_t z,
+                     int64_t k,
+                     T d_approx,
+                     const Primes& primes,
+                     const PiTable& pi,
+                     int threads,
+                     bool is_print)
+{
+  // The backup file and the worker processes
+  // require computing D(x, y) in a single pass.
+  // The memory plan of the outermost pi(x)
+  // computation does not apply to nested pi(x)
+  // computations, their FactorTableD is small.
+  int64_t segments = max(get_factor_table_segments(), get_max_memory_segments());
+  if (is_backup() || is_worker() || is_nested())
+    segments = 1;
+
+  // Segments must start at a number n with n % 2310 = 1
+  int64_t dist = ceil_div(max(z, 1), segments);
+  dist += (2310 - dist % 2310) % 2310;
+  int64_t passes = ceil_div(max(z, 1), dist);
+  T sum = 0;
+
+  if (is_print && passes > 1)
+    print("factor table segments", passes);
+
+  // Each pass computes about 1 / passes of D(x, y)
+  for (int64_t pass = 0; pass < passes; pass++)
+  {
+    int64_t low = 1 + pass * dist;
+    FactorTableD factor(y, z, low, low + dist - 1, threads);
+    sum += D_OpenMP(x, y, z, k, d_approx / passes, primes, pi, factor, threads, is_print, pass, passes);
+  }
+
+  return sum;
+}
+
 } // namespace
 
 namespace primecount {
@@ -241,14 +625,21 @@ int64_t D(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== D(x, y) ===");
+    print_header("D(x, y)");
     print_gourdon_vars(x, y, z, k, threads);
     time = get_time();
   }
 
-  FactorTableD<uint16_t> factor(y, z, threads);
-  auto primes = generate_primes<uint32_t>(y);
-  int64_t sum = D_OpenMP(x, y, z, k, d_approx, primes, factor, threads, is_print);
+  int64_t sum;
+
+  if (is_coordinator())
+    sum = D_coordinator(x, y, z, k, d_approx, is_print);
+  else
+  {
+    auto primes = generate_primes<uint32_t>(y);
+    PiTable pi(y, threads);
+    sum = D_OpenMP_segmented<FactorTableD<uint16_t>>(x, y, z, k, d_approx, primes, pi, threads, is_print);
+  }
 
   if (is_print)
     print("D", sum, time);
@@ -256,6 +647,74 @@ int64_t D(int64_t x,
   return sum;
 }
 
+/// Compute D(x, y) for multiple x that share the same y, z
+/// and k. The lookup tables only depend on y and z, hence
+/// they are initialized only once for all x. All x are
+/// computed in a single pass over the sieving interval.
+/// @pre x is sorted in ascending order.
+///
+Vector<int64_t> D(const Vector<int64_t>& x,
+                  int64_t y,
+                  int64_t z,
+                  int64_t k,
+                  const Vector<int64_t>& d_approx,
+                  int threads,
+                  bool is_print)
+{
+  ASSERT(x.size() == d_approx.size());
+  Vector<int64_t> sums(x.size());
+
+  if (x.empty())
+    return sums;
+
+  FactorTableD<uint16_t> factor(y, z, threads);
+  auto primes = generate_primes<uint32_t>(y);
+  PiTable pi(y, threads);
+
+  if (x.size() == 1)
+  {
+    double time;
+
+    if (is_print)
+    {
+      print("");
+      print_header("D(x, y)");
+      print_gourdon_vars(x[0], y, z, k, threads);
+      time = get_time();
+    }
+
+    sums[0] = D_OpenMP(x[0], y, z, k, d_approx[0], primes, pi, factor, threads, is_print);
+
+    if (is_print)
+      print("D", sums[0], time);
+
+    return sums;
+  }
+
+  double time;
+
+  if (is_print)
+  {
+    print("");
+    print_header("D(x, y) batch");
+    print_gourdon_vars(x[x.size() - 1], y, z, k, threads);
+    print("batch size", (int64_t) x.size());
+    time = get_time();
+  }
+
+  sums = D_OpenMP_batch(x, y, z, k, d_approx[x.size() - 1], primes, pi, factor, threads, is_print);
+
+  // The last result ends the batch
+  if (is_print)
+  {
+    for (std::size_t i = 0; i + 1 < x.size(); i++)
+      print("D", sums[i]);
+    print("D", sums[x.size() - 1], time);
+  }
+
+  return sums;
+}
+
 #ifdef HAVE_INT128_T
 
 int128_t D(int128_t x,
@@ -271,25 +730,27 @@ int128_t D(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== D(x, y) ===");
+    print_header("D(x, y)");
     print_gourdon_vars(x, y, z, k, threads);
     time = get_time();
   }
 
   int128_t sum;
 
+  if (is_coordinator())
+    sum = D_coordinator(x, y, z, k, d_approx, is_print);
   // uses less memory
-  if (z <= FactorTableD<uint16_t>::max())
+  else if (z <= FactorTableD<uint16_t>::max())
   {
-    FactorTableD<uint16_t> factor(y, z, threads);
     auto primes = generate_primes<uint32_t>(y);
-    sum = D_OpenMP(x, y, z, k, d_approx, primes, factor, threads, is_print);
+    PiTable pi(y, threads);
+    sum = D_OpenMP_segmented<FactorTableD<uint16_t>>(x, y, z, k, d_approx, primes, pi, threads, is_print);
   }
   else
   {
-    FactorTableD<uint32_t> factor(y, z, threads);
     auto primes = generate_primes<int64_t>(y);
-    sum = D_OpenMP(x, y, z, k, d_approx, primes, factor, threads, is_print);
+    PiTable pi(y, threads);
+    sum = D_OpenMP_segmented<FactorTableD<uint32_t>>(x, y, z, k, d_approx, primes, pi, threads, is_print);
   }
 
   if (is_print)
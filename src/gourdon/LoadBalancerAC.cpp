@@ -7,6 +7,13 @@
 ///        Load balancing is described in more detail at:
 ///        https://github.com/kimwalisch/primecount/blob/master/doc/Easy-Special-Leaves.md
 ///
+///        In distributed mode (see distributed.hpp) the coordinator
+///        process assigns the segments to the threads of the worker
+///        processes. The workers send the sum of their previous
+///        chunk together with their request for new work, the
+///        coordinator adds up these sums using maxint_t. The
+///        segments of workers that have died are reassigned.
+///
 /// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
@@ -15,27 +22,54 @@
 
 #include <LoadBalancerAC.hpp>
 #include <SegmentedPiTable.hpp>
-#include <primecount-config.hpp>
+#include <cpu_cache.hpp>
+#include <distributed.hpp>
+#include <primecount.hpp>
 #include <primecount-internal.hpp>
+#include <print.hpp>
 #include <imath.hpp>
+#include <progress.hpp>
+#include <trace.hpp>
+#include <int128_t.hpp>
 
 #include <stdint.h>
 #include <algorithm>
+#include <chrono>
+#include <exception>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <thread>
 
 namespace primecount {
 
-LoadBalancerAC::LoadBalancerAC(int64_t sqrtx,
+LoadBalancerAC::LoadBalancerAC(maxint_t x,
+                               int64_t sqrtx,
                                int64_t y,
+                               int64_t z,
+                               int64_t k,
                                int threads,
                                bool is_print) :
+  x_(x),
   sqrtx_(sqrtx),
   y_(y),
+  z_(z),
+  k_(k),
   threads_(threads),
-  is_print_(is_print)
+  is_print_(is_print),
+  is_worker_(is_worker()),
+  is_coordinator_(is_coordinator()),
+  is_nested_(is_nested()),
+  is_trace_(is_trace() && !is_nested_),
+  progress_(get_progress())
 {
   lock_.init(threads);
+
+  // The coordinator counts the threads
+  // of the worker processes.
+  if (is_coordinator_)
+    threads_ = 0;
+
   int64_t x14 = isqrt(sqrtx);
 
   // Minimum segment size = 512 bytes.
@@ -45,14 +79,20 @@ LoadBalancerAC::LoadBalancerAC(int64_t sqrtx,
   // The maximum segment size matches the CPU's L2 cache
   // size (unless x^(1/4) > L2 cache size). This way
   // we ensure that most memory accesses will be cache
-  // hits and we get good performance.
-  int64_t l2_segment_size = L2_CACHE_SIZE * SegmentedPiTable::numbers_per_byte();
+  // hits and we get good performance. The L2 cache
+  // size is detected at runtime.
+  int64_t l2_segment_size = get_l2_cache_size() * SegmentedPiTable::numbers_per_byte();
 
-  if (threads == 1 && !is_print)
+  if (threads == 1 &&
+      !is_print &&
+      !progress_ &&
+      !is_coordinator_)
   {
     // When using a single thread (and printing is disabled)
     // we can use a segment size larger than x^(1/4)
     // because load balancing is only needed for multi-threading.
+    // pi_async(x) requires multiple chunks for progress
+    // reporting and cancellation.
     segment_size_ = std::max(x14, l2_segment_size);
     segments_ = ceil_div(sqrtx, segment_size_);
   }
@@ -71,20 +111,76 @@ LoadBalancerAC::LoadBalancerAC(int64_t sqrtx,
   max_segment_size_ = std::max(l2_segment_size, segment_size_);
   max_segment_size_ = SegmentedPiTable::get_segment_size(max_segment_size_);
 
-  if (is_print_)
+  if (is_print_ && !is_worker_)
     print_status(get_time());
 }
 
+/// Only compute the segments inside [low, high[ instead
+/// of [0, sqrtx[, used to split the computation into
+/// chunks (--low=L --high=H).
+///
+void LoadBalancerAC::set_interval(int64_t low, int64_t high)
+{
+  start_ = low;
+  low_ = low;
+  sqrtx_ = high;
+}
+
+maxint_t LoadBalancerAC::get_sum() const
+{
+  // Exceptions must not be thrown inside
+  // an OpenMP parallel region.
+  if (!error_.empty())
+    throw primecount_error(error_);
+  // The sum of a cancelled computation is incomplete
+  if (progress_)
+    progress_->check_cancelled();
+
+  return sum_;
+}
+
 bool LoadBalancerAC::get_work(ThreadDataAC& thread)
 {
   double time = get_time();
   thread.secs = time - thread.secs;
 
+  if (is_worker_)
+    return get_remote_work(thread);
+
   LockGuard lockGuard(lock_);
 
-  if (low_ >= sqrtx_)
+  if (thread.segments > 0)
+  {
+    thread.total_chunks++;
+    thread.total_segments += thread.segments;
+    thread.total_secs += thread.secs;
+  }
+
+  if (is_trace_)
+    trace(thread, time);
+
+  bool is_work = assign_work(thread, time);
+
+  // In JSON mode (--json) the statistics of all
+  // threads are printed together with the result.
+  // The threads of nested pi(x) computations (e.g.
+  // inside the B formula) are not part of it.
+  if (!is_work && is_print_json() && !is_nested_)
+    add_thread_stats(thread.total_chunks, thread.total_segments, 0, thread.total_secs);
+
+  return is_work;
+}
+
+bool LoadBalancerAC::assign_work(ThreadDataAC& thread, double time)
+{
+  sum_ += thread.sum;
+  thread.sum = 0;
+
+  if (progress_)
+    progress_->report(get_percent(low_, sqrtx_));
+  if (low_ >= sqrtx_ || (progress_ && progress_->is_cancelled()))
     return false;
-  if (low_ == 0)
+  if (low_ == start_)
     start_time_ = time;
 
   int64_t remaining_dist = sqrtx_ - low_;
@@ -132,6 +228,161 @@ bool LoadBalancerAC::get_work(ThreadDataAC& thread)
   return thread.low < sqrtx_;
 }
 
+/// Assign the segments to the worker processes
+/// until all segments have been finished.
+///
+void LoadBalancerAC::serve_workers()
+{
+  serve_requests([&](const std::string& request) { return reply_worker(request); },
+                 [&] { return is_finished(); });
+}
+
+/// All segments have been assigned and
+/// all assigned segments have been finished.
+///
+bool LoadBalancerAC::is_finished() const
+{
+  return low_ >= sqrtx_ &&
+         remote_.empty();
+}
+
+/// Request: AC x y z k start sqrtx low segments segment_size sum secs is_new
+/// Reply: "work low segments segment_size" or "wait" or "finished" or "error msg"
+/// is_new = 1 for the first request of a worker thread.
+///
+std::string LoadBalancerAC::reply_worker(const std::string& request)
+{
+  std::istringstream iss(request);
+  std::string formula, x, sum;
+  int64_t y, z, k, start, sqrtx;
+  ThreadDataAC thread;
+  int is_new;
+
+  if (!(iss >> formula >> x >> y >> z >> k >> start >> sqrtx
+            >> thread.low >> thread.segments >> thread.segment_size
+            >> sum >> thread.secs >> is_new))
+    return "error invalid request: " + request;
+
+  if (formula != "AC" ||
+      x != to_string(x_) ||
+      y != y_ || z != z_ || k != k_ ||
+      start != start_ || sqrtx != sqrtx_)
+  {
+    std::ostringstream oss;
+    oss << "error the coordinator computes AC(x = " << x_ << ", y = "
+        << y_ << ", z = " << z_ << ", k = " << k_ << ") in ["
+        << start_ << ", " << sqrtx_ << "[";
+    return oss.str();
+  }
+
+  try { thread.sum = to_maxint(sum); }
+  catch (std::exception&) { return "error invalid request: " + request; }
+
+  // New worker thread, an idle worker thread
+  // that polls for work also sends segments = 0.
+  if (is_new)
+    threads_++;
+
+  // The expired chunk has already been
+  // finished by another worker.
+  if (thread.segments > 0 &&
+      !remote_.finish(thread.low, thread.secs))
+    thread.sum = 0;
+
+  RemoteChunks::Chunk chunk;
+
+  if (remote_.get_expired(chunk))
+  {
+    sum_ += thread.sum;
+    thread.sum = 0;
+    thread.low = chunk.low;
+    thread.segments = chunk.segments;
+    thread.segment_size = chunk.segment_size;
+  }
+  else if (!assign_work(thread, get_time()))
+    return is_finished() ? "finished" : "wait";
+
+  remote_.assign({thread.low, thread.segments, thread.segment_size});
+
+  return "work " + std::to_string(thread.low) + " " +
+                   std::to_string(thread.segments) + " " +
+                   std::to_string(thread.segment_size);
+}
+
+/// Send the sum of the previous chunk to the coordinator
+/// and request a new chunk (worker process). Note that
+/// sum_ is the sum of all chunks computed by this worker.
+///
+bool LoadBalancerAC::get_remote_work(ThreadDataAC& thread)
+{
+  try
+  {
+    {
+      LockGuard lockGuard(lock_);
+      sum_ += thread.sum;
+      if (!error_.empty())
+        return false;
+    }
+
+    while (true)
+    {
+      std::ostringstream request;
+      request << "AC " << x_ << ' ' << y_ << ' ' << z_ << ' ' << k_ << ' '
+              << start_ << ' ' << sqrtx_ << ' ' << thread.low << ' ' << thread.segments << ' ' << thread.segment_size << ' '
+              << thread.sum << ' ' << thread.secs << ' ' << !thread.is_registered;
+
+      thread.sum = 0;
+      thread.segments = 0;
+      thread.is_registered = true;
+
+      // An empty reply means that the coordinator
+      // has finished the computation and exited.
+      std::string reply = send_request(request.str());
+      std::istringstream iss(reply);
+      std::string status;
+      iss >> status;
+
+      if (status == "work" &&
+          iss >> thread.low >> thread.segments >> thread.segment_size)
+        return true;
+      if (status == "error")
+        throw primecount_error("coordinator: " + reply.substr(6));
+      if (status != "wait")
+        return false;
+
+      // Wait until an expired chunk is reassigned
+      // or until all chunks have been finished.
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+  }
+  catch (std::exception& e)
+  {
+    LockGuard lockGuard(lock_);
+    error_ = e.what();
+    return false;
+  }
+}
+
+/// Record the chunk that has just been finished by the
+/// thread (--trace=FILE). The time waiting for the lock
+/// is attributed to the thread's next chunk.
+///
+void LoadBalancerAC::trace(ThreadDataAC& thread, double lock_time)
+{
+  double time = get_time();
+
+  if (thread.id < 0)
+    thread.id = thread_ids_++;
+
+  if (thread.segments > 0)
+    add_trace_chunk(TraceChunk{"AC", thread.id, thread.assigned_time - start_time_,
+                               thread.low, thread.segments, thread.segment_size,
+                               thread.wait_secs, 0, thread.secs});
+
+  thread.assigned_time = time;
+  thread.wait_secs = time - lock_time;
+}
+
 void LoadBalancerAC::print_status(double time)
 {
   double threshold = 0.1;
@@ -140,6 +391,12 @@ void LoadBalancerAC::print_status(double time)
   {
     print_time_ = time;
 
+    if (is_print_json())
+    {
+      print_json_status(get_percent(low_, sqrtx_));
+      return;
+    }
+
     int64_t remaining_dist = sqrtx_ - low_;
     int64_t thread_dist = segments_ * segment_size_;
     int64_t total_segments = ceil_div(remaining_dist, thread_dist);
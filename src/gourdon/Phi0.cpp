@@ -108,7 +108,7 @@ int64_t Phi0(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== Phi0(x, y) ===");
+    print_header("Phi0(x, y)");
     print_gourdon_vars(x, y, z, k, threads);
     time = get_time();
   }
@@ -135,7 +135,7 @@ int128_t Phi0(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== Phi0(x, y) ===");
+    print_header("Phi0(x, y)");
     print_gourdon_vars(x, y, z, k, threads);
     time = get_time();
   }
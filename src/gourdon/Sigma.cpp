@@ -109,7 +109,7 @@ int64_t Sigma(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== Sigma(x, y) ===");
+    print_header("Sigma(x, y)");
     print_gourdon_vars(x, y, threads);
     time = get_time();
   }
@@ -150,7 +150,7 @@ int128_t Sigma(int128_t x,
   if (is_print)
   {
     print("");
-    print("=== Sigma(x, y) ===");
+    print_header("Sigma(x, y)");
     print_gourdon_vars(x, y, threads);
     time = get_time();
   }
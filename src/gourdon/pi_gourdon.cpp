@@ -9,6 +9,11 @@
 ///        Xavier Gourdon formula:
 ///        pi(x) = A - B + C + D + Phi0 + Sigma
 ///
+///        If a backup file is used (--backup=FILE), the result of
+///        each formula is stored in the backup file once it has been
+///        computed. When the computation is resumed, the formulas
+///        whose results are in the backup file are not recomputed.
+///
 /// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
@@ -16,57 +21,174 @@
 ///
 
 #include <gourdon.hpp>
+#include <backup.hpp>
 #include <primecount.hpp>
 #include <primecount-internal.hpp>
 #include <imath.hpp>
+#include <int128_t.hpp>
 #include <macros.hpp>
+#include <max_memory.hpp>
 #include <PhiTiny.hpp>
 #include <print.hpp>
+#include <progress.hpp>
+#include <Vector.hpp>
 
 #include <stdint.h>
 #include <algorithm>
+#include <cstddef>
 #include <string>
 
-namespace primecount {
+using namespace primecount;
 
-/// Calculate the number of primes below x using
-/// Xavier Gourdon's algorithm.
-/// Run time: O(x^(2/3) / (log x)^2)
-/// Memory usage: O(x^(1/3) * (log x)^3)
+namespace {
+
+/// Used by pi_async(x): map the progress of the formula
+/// to the progress of the entire pi(x) computation. The
+/// percentages correspond to the run time of the formulas
+/// for x = 10^16.
 ///
-int64_t pi_gourdon_64(int64_t x,
-                      int threads,
-                      bool is_print)
+void set_progress_range(const std::string& formula)
 {
-  if (x < 2)
-    return 0;
+  Progress* progress = get_progress();
+
+  if (!progress)
+    return;
+
+  if (formula == "Sigma")
+    progress->set_range(0, 0.1);
+  else if (formula == "Phi0")
+    progress->set_range(0.1, 1);
+  else if (formula == "AC")
+    progress->set_range(1, 31);
+  else if (formula == "B")
+    progress->set_range(31, 51);
+  else if (formula == "D")
+    progress->set_range(51, 100);
+}
+
+/// The result of a cancelled formula is incomplete.
+/// Nested pi(x) computations have no progress (see
+/// get_progress()), they are never cancelled.
+///
+void check_cancelled()
+{
+  Progress* progress = get_progress();
+
+  if (progress)
+    progress->check_cancelled();
+}
+
+/// Load the result of the formula from the backup file. If the
+/// formula has not yet been computed, compute it and store its
+/// result in the backup file. The results are keyed by
+/// (x, y, z, k) and the primecount version.
+///
+template <typename T, typename Formula>
+T backup_formula(const std::string& formula,
+                 T x,
+                 int64_t y,
+                 int64_t z,
+                 int64_t k,
+                 bool is_print,
+                 Formula compute)
+{
+  set_progress_range(formula);
+
+  if (!is_backup())
+  {
+    T res = compute();
+    check_cancelled();
+    return res;
+  }
+
+  std::string key = "pi_gourdon." + formula;
+  Backup backup = load_backup();
+
+  if (is_resume(backup, "pi_gourdon", x, y, z, k) &&
+      backup.count(key))
+  {
+    T res = (T) to_maxint(backup[key]);
+
+    if (is_print)
+    {
+      // In JSON mode only the value record is printed
+      std::string msg = "=== Resuming " + formula + " from " + backup_file() + " ===";
+      print("");
+      print(msg.c_str());
+      print(formula.c_str(), res);
+    }
+
+    return res;
+  }
+
+  T res = compute();
+  check_cancelled();
+
+  // The formula may have modified the backup file
+  // e.g. D(x, y) stores its intermediate results.
+  backup = load_backup();
+  if (!is_resume(backup, "pi_gourdon", x, y, z, k))
+    reset_backup(backup, "pi_gourdon", x, y, z, k);
+  backup[key] = to_string((maxint_t) res);
+  store_backup(backup);
+
+  return res;
+}
 
+/// Calculate y and z for Gourdon's algorithm.
+/// x^(1/3) < y < x^(1/2) and y <= z < x^(1/2).
+///
+template <typename T>
+void get_yz(T x, int64_t& y, int64_t& z)
+{
   auto alpha = get_alpha_gourdon(x);
   double alpha_y = alpha.first;
   double alpha_z = alpha.second;
   int64_t x13 = iroot<3>(x);
   int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
+  y = (int64_t)(x13 * alpha_y);
 
   // x^(1/3) < y < x^(1/2)
   y = std::max(y, x13 + 1);
   y = std::min(y, sqrtx - 1);
   y = std::max(y, (int64_t) 1);
 
-  int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
+  z = (int64_t)(y * alpha_z);
 
   // y <= z < x^(1/2)
   z = std::max(z, y);
   z = std::min(z, sqrtx - 1);
   z = std::max(z, (int64_t) 1);
+}
+
+} // namespace
+
+namespace primecount {
+
+/// Calculate the number of primes below x using
+/// Xavier Gourdon's algorithm.
+/// Run time: O(x^(2/3) / (log x)^2)
+/// Memory usage: O(x^(1/3) * (log x)^3)
+///
+int64_t pi_gourdon_64(int64_t x,
+                      int threads,
+                      bool is_print)
+{
+  if (x < 2)
+    return 0;
+
+  int64_t y, z;
+  get_yz(x, y, z);
+  MaxMemory max_memory(x, y, z, threads);
+  int64_t k = PhiTiny::get_k(x);
 
   if (is_print)
   {
     print("");
-    print("=== pi_gourdon_64(x) ===");
+    print_header("pi_gourdon_64(x)");
     print("pi(x) = A - B + C + D + Phi0 + Sigma");
     print_gourdon(x, y, z, k, threads);
+    print_max_memory(gourdon_memory(x, y, z, threads));
   }
 
   // For very short computations (< 1 second) we achieve the best
@@ -79,17 +201,109 @@ int64_t pi_gourdon_64(int64_t x,
   // the CPU and memory (i.e. the B algorithm) we would overload
   // both the CPU and operating system.
 
-  int64_t sigma = Sigma(x, y, threads, is_print);
-  int64_t phi0 = Phi0(x, y, z, k, threads, is_print);
-  int64_t ac = AC(x, y, z, k, threads, is_print);
-  int64_t b = B(x, y, threads, is_print);
+  int64_t sigma = backup_formula("Sigma", x, y, z, k, is_print, [&] {
+    return Sigma(x, y, threads, is_print); });
+  int64_t phi0 = backup_formula("Phi0", x, y, z, k, is_print, [&] {
+    return Phi0(x, y, z, k, threads, is_print); });
+  int64_t ac = backup_formula("AC", x, y, z, k, is_print, [&] {
+    return AC(x, y, z, k, threads, is_print); });
+  int64_t b = backup_formula("B", x, y, z, k, is_print, [&] {
+    return B(x, y, threads, is_print); });
   int64_t d_approx = D_approx(x, sigma, phi0, ac, b);
-  int64_t d = D(x, y, z, k, d_approx, threads, is_print);
+  int64_t d = backup_formula("D", x, y, z, k, is_print, [&] {
+    return D(x, y, z, k, d_approx, threads, is_print); });
   int64_t sum = ac - b + d + phi0 + sigma;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
+/// Calculate the number of primes below each x using Xavier
+/// Gourdon's algorithm. The x values must be sorted in ascending
+/// order and x >= 2. Nearby x values are grouped together and
+/// share the same y, z and k. This way the lookup tables of the
+/// A + C and D formulas (primes, PiTable, FactorTableD) are
+/// initialized only once per group instead of once per x.
+///
+Vector<int64_t> pi_gourdon_64(const Vector<int64_t>& x,
+                              int threads,
+                              bool is_print)
+{
+  Vector<int64_t> pix(x.size());
+  std::size_t end = x.size();
+
+  while (end > 0)
+  {
+    int64_t max_x = x[end - 1];
+    int64_t y, z;
+    get_yz(max_x, y, z);
+    // The batch D formula uses the entire FactorTableD
+    MaxMemory max_memory(max_x, y, z, threads, false);
+    int64_t k = PhiTiny::get_k(max_x);
+    std::size_t begin = end - 1;
+
+    // y > x^(1/3) holds for all x <= max_x, but we must
+    // also ensure that z < x^(1/2). Since y and z have been
+    // tuned for max_x we only add x >= max_x / 2 to the group,
+    // this way the alpha factors stay close to optimal.
+    while (begin > 0 &&
+           x[begin - 1] >= max_x / 2 &&
+           z < isqrt(x[begin - 1]) &&
+           (int64_t) PhiTiny::get_k(x[begin - 1]) == k)
+      begin--;
+
+    std::size_t size = end - begin;
+    Vector<int64_t> group(size);
+    Vector<int64_t> sigma(size);
+    Vector<int64_t> phi0(size);
+    Vector<int64_t> b(size);
+    Vector<int64_t> d_approx(size);
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+      group[i] = x[begin + i];
+
+      if (is_print)
+      {
+        print("");
+        print_header("pi_gourdon_64(x)");
+        print("pi(x) = A - B + C + D + Phi0 + Sigma");
+        print_gourdon(group[i], y, z, k, threads);
+        print_max_memory(gourdon_memory(max_x, y, z, threads));
+      }
+    }
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+      sigma[i] = Sigma(group[i], y, threads, is_print);
+      phi0[i] = Phi0(group[i], y, z, k, threads, is_print);
+    }
+
+    Vector<int64_t> ac = AC(group, y, z, k, threads, is_print);
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+      b[i] = B(group[i], y, threads, is_print);
+      d_approx[i] = D_approx(group[i], sigma[i], phi0[i], ac[i], b[i]);
+    }
+
+    Vector<int64_t> d = D(group, y, z, k, d_approx, threads, is_print);
+
+    for (std::size_t i = 0; i < size; i++)
+    {
+      pix[begin + i] = ac[i] - b[i] + d[i] + phi0[i] + sigma[i];
+      if (is_print)
+        print_footer();
+    }
+
+    end = begin;
+  }
+
+  return pix;
+}
+
 #if defined(HAVE_INT128_T)
 
 /// Calculate the number of primes below x using
@@ -104,37 +318,24 @@ int128_t pi_gourdon_128(int128_t x,
   if (x < 2)
     return 0;
 
-  auto alpha = get_alpha_gourdon(x);
-  double alpha_y = alpha.first;
-  double alpha_z = alpha.second;
+  double alpha_y = get_alpha_gourdon(x).first;
   maxint_t limit = get_max_x(alpha_y);
 
   if_unlikely(x > limit)
     throw primecount_error("pi(x): x must be <= " + to_string(limit));
 
-  int64_t x13 = iroot<3>(x);
-  int64_t sqrtx = isqrt(x);
-  int64_t y = (int64_t)(x13 * alpha_y);
-
-  // x^(1/3) < y < x^(1/2)
-  y = std::max(y, x13 + 1);
-  y = std::min(y, sqrtx - 1);
-  y = std::max(y, (int64_t) 1);
-
+  int64_t y, z;
+  get_yz(x, y, z);
+  MaxMemory max_memory(x, y, z, threads);
   int64_t k = PhiTiny::get_k(x);
-  int64_t z = (int64_t)(y * alpha_z);
-
-  // y <= z < x^(1/2)
-  z = std::max(z, y);
-  z = std::min(z, sqrtx - 1);
-  z = std::max(z, (int64_t) 1);
 
   if (is_print)
   {
     print("");
-    print("=== pi_gourdon_128(x) ===");
+    print_header("pi_gourdon_128(x)");
     print("pi(x) = A - B + C + D + Phi0 + Sigma");
     print_gourdon(x, y, z, k, threads);
+    print_max_memory(gourdon_memory(x, y, z, threads));
   }
 
   // For very short computations (< 1 second) we achieve the best
@@ -147,14 +348,22 @@ int128_t pi_gourdon_128(int128_t x,
   // the CPU and memory (i.e. the B algorithm) we would overload
   // both the CPU and operating system.
 
-  int128_t sigma = Sigma(x, y, threads, is_print);
-  int128_t phi0 = Phi0(x, y, z, k, threads, is_print);
-  int128_t ac = AC(x, y, z, k, threads, is_print);
-  int128_t b = B(x, y, threads, is_print);
+  int128_t sigma = backup_formula("Sigma", x, y, z, k, is_print, [&] {
+    return Sigma(x, y, threads, is_print); });
+  int128_t phi0 = backup_formula("Phi0", x, y, z, k, is_print, [&] {
+    return Phi0(x, y, z, k, threads, is_print); });
+  int128_t ac = backup_formula("AC", x, y, z, k, is_print, [&] {
+    return AC(x, y, z, k, threads, is_print); });
+  int128_t b = backup_formula("B", x, y, z, k, is_print, [&] {
+    return B(x, y, threads, is_print); });
   int128_t d_approx = D_approx(x, sigma, phi0, ac, b);
-  int128_t d = D(x, y, z, k, d_approx, threads, is_print);
+  int128_t d = backup_formula("D", x, y, z, k, is_print, [&] {
+    return D(x, y, z, k, d_approx, threads, is_print); });
   int128_t sum = ac - b + d + phi0 + sigma;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
@@ -53,7 +53,7 @@ int64_t S2(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== S2(x, y) ===");
+    print_header("S2(x, y)");
     time = get_time();
   }
 
@@ -166,7 +166,7 @@ int64_t pi_lmo5(int64_t x, bool is_print)
   if (is_print)
   {
     print("");
-    print("=== pi_lmo5(x) ===");
+    print_header("pi_lmo5(x)");
     print("pi(x) = S1 + S2 + pi(y) - 1 - P2");
     print(x, y, z, c, threads);
   }
@@ -182,6 +182,9 @@ int64_t pi_lmo5(int64_t x, bool is_print)
   int64_t phi = s1 + s2;
   int64_t sum = phi + pi_y - 1 - p2;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
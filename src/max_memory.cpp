@@ -0,0 +1,354 @@
+///
+/// @file  max_memory.cpp
+/// @brief Memory limit (--max-memory=BYTES). The peak memory
+///        usage of pi(x) is predicted from the sizes of the
+///        lookup tables (primes, PiTable, FactorTable) and of the
+///        per thread data structures (sieve, phi cache, ...) of
+///        each formula. If the predicted memory usage exceeds the
+///        memory limit we (in that order) shrink the PhiCache,
+///        split the FactorTableD into segments, decrease the alpha
+///        tuning factors (i.e. y and z) and decrease the number of
+///        threads. Note that this is a model and not a
+///        measurement, e.g. heap fragmentation is ignored.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <max_memory.hpp>
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <backup.hpp>
+#include <cpu_cache.hpp>
+#include <distributed.hpp>
+#include <FactorTable.hpp>
+#include <FactorTableD.hpp>
+#include <imath.hpp>
+#include <int128_t.hpp>
+#include <numa.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+using namespace primecount;
+
+namespace {
+
+/// 0 = no memory limit
+int64_t max_memory_ = 0;
+
+/// The PhiCache uses at most 16 MiB per thread
+/// if the memory limit is large enough.
+const int64_t max_phi_cache_size = 16 << 20;
+const int64_t min_phi_cache_size = 1 << 20;
+int64_t phi_cache_size_ = max_phi_cache_size;
+
+/// Max number of FactorTableD segments, each
+/// segment sieves the interval [0, x / z[ once.
+const int max_factor_table_segments = 16;
+int max_memory_segments_ = 1;
+
+/// True while a pi(x) computation uses the memory plan,
+/// concurrent pi(x) computations (e.g. pi_async()) must
+/// not overwrite it.
+std::atomic<bool> is_planned_(false);
+
+/// Memory used independently of x: the program
+/// itself, the pi(x) cache, ... (about 11 MiB).
+const int64_t base_bytes = 12 << 20;
+const int64_t thread_bytes = 1 << 20;
+
+/// Upper bound for pi(n), Li(n) > pi(n) has
+/// been verified for all n < 10^19.
+int64_t pi_bound(int64_t n)
+{
+  if (n < 10)
+    return 4;
+  else
+    return Li(n);
+}
+
+int64_t primes_bytes(int64_t n)
+{
+  return (pi_bound(n) + 1) * (int64_t) sizeof(uint32_t);
+}
+
+/// PiTable uses 16 bytes per 240 numbers
+int64_t pi_table_bytes(int64_t n)
+{
+  return ceil_div(n + 1, 240) * 16;
+}
+
+/// FactorTable & FactorTableD store 480
+/// numbers per 2310 numbers.
+int64_t factor_table_bytes(int64_t n, int64_t entry_bytes)
+{
+  return (n / 2310 + 1) * 480 * entry_bytes;
+}
+
+/// The LoadBalancerS2 sieve array uses
+/// max(min(2 * L1d, L2), sqrt(limit) / 30) bytes.
+int64_t sieve_bytes(maxint_t limit)
+{
+  int64_t bytes = std::min(get_l1d_cache_size() * 2, get_l2_cache_size());
+  return std::max(bytes, (int64_t) isqrt(limit) / 30);
+}
+
+/// The sieving primes of primesieve::iterator
+/// use about 8 bytes per prime.
+int64_t primesieve_bytes(maxint_t limit)
+{
+  return pi_bound((int64_t) isqrt(limit)) * 8 + get_l2_cache_size();
+}
+
+/// The read-only lookup tables are replicated
+/// on each NUMA node (see NumaReplicas).
+int64_t numa_copies()
+{
+  return 1 + ((is_numa() && numa_nodes() > 1) ? numa_nodes() : 0);
+}
+
+int64_t gourdon_bytes(maxint_t x,
+                      int64_t y,
+                      int64_t z,
+                      int threads,
+                      int segments,
+                      int64_t phi_cache_size)
+{
+  int64_t x_star = get_x_star_gourdon(x, y);
+  int64_t max_a_prime = (int64_t) isqrt(x / x_star);
+  int64_t copies = numa_copies();
+
+  // Sigma & Phi0
+  int64_t phi0 = primes_bytes(y) + threads * (thread_bytes + phi_cache_size);
+
+  // A + C
+  int64_t ac = primes_bytes(std::max(y, max_a_prime));
+  ac += pi_table_bytes(std::max(z, max_a_prime)) * copies;
+  ac += threads * (thread_bytes + get_l2_cache_size());
+
+  // B
+  int64_t b = threads * (thread_bytes + primesieve_bytes(x / y));
+
+  // D, the phi vector and the Sieve's wheel
+  // use about 24 bytes per sieving prime.
+  int64_t entry_bytes = (z <= FactorTableD<uint16_t>::max()) ? 2 : 4;
+  int64_t factor = ceil_div(factor_table_bytes(z, entry_bytes), segments);
+  int64_t d = primes_bytes(y) + (pi_table_bytes(y) + factor) * copies;
+  d += threads * (thread_bytes + sieve_bytes(x / z) + pi_bound(x_star) * 24 + phi_cache_size);
+
+  return base_bytes + std::max({phi0, ac, b, d});
+}
+
+int64_t deleglise_rivat_bytes(maxint_t x,
+                              int64_t y,
+                              int threads,
+                              int64_t phi_cache_size)
+{
+  maxint_t z = x / std::max(y, (int64_t) 1);
+  int64_t sqrtz = (int64_t) isqrt(z);
+  int64_t max_prime = std::min(y, (int64_t) (z / isqrt(y)));
+  int64_t copies = numa_copies();
+
+  // P2 & S1
+  int64_t p2 = threads * (thread_bytes + primesieve_bytes(z));
+
+  // S2_easy
+  int64_t s2_easy = primes_bytes(y) + pi_table_bytes(y) * copies;
+  s2_easy += threads * thread_bytes;
+
+  // S2_hard, the phi vector and the Sieve's wheel
+  // use about 24 bytes per sieving prime.
+  int64_t entry_bytes = (y <= FactorTable<uint16_t>::max()) ? 2 : 4;
+  int64_t s2_hard = primes_bytes(max_prime);
+  s2_hard += (pi_table_bytes(max_prime) + factor_table_bytes(y, entry_bytes)) * copies;
+  s2_hard += threads * (thread_bytes + sieve_bytes(z) + pi_bound(sqrtz) * 24 + phi_cache_size);
+
+  return base_bytes + std::max({p2, s2_easy, s2_hard});
+}
+
+std::string to_mib(int64_t bytes)
+{
+  return std::to_string(ceil_div(bytes, 1 << 20)) + " MiB";
+}
+
+void throw_max_memory(int64_t bytes)
+{
+  throw primecount_error("max memory " + to_mib(max_memory_) +
+                         " is too small, pi(x) requires at least " +
+                         to_mib(bytes));
+}
+
+} // namespace
+
+namespace primecount {
+
+/// Set a memory limit in bytes for pi(x),
+/// 0 disables the memory limit.
+///
+void set_max_memory(int64_t bytes)
+{
+  if (bytes < 0)
+    throw primecount_error("max memory must be >= 0");
+
+  max_memory_ = bytes;
+}
+
+int64_t get_max_memory()
+{
+  return max_memory_;
+}
+
+int64_t get_phi_cache_size()
+{
+  return phi_cache_size_;
+}
+
+int get_max_memory_segments()
+{
+  return max_memory_segments_;
+}
+
+int64_t gourdon_memory(maxint_t x, int64_t y, int64_t z, int threads)
+{
+  int segments = std::max(get_factor_table_segments(), max_memory_segments_);
+  return gourdon_bytes(x, y, z, threads, segments, phi_cache_size_);
+}
+
+int64_t deleglise_rivat_memory(maxint_t x, int64_t y, int threads)
+{
+  return deleglise_rivat_bytes(x, y, threads, phi_cache_size_);
+}
+
+/// Only the outermost pi(x) computation plans the memory
+/// usage, nested pi(x) computations use its plan. The memory
+/// limit cannot be shared by multiple pi(x) computations
+/// that run at the same time (e.g. pi_async()), hence
+/// these are rejected.
+///
+bool MaxMemory::lock()
+{
+  if (max_memory_ <= 0 || is_nested())
+    return false;
+
+  if (is_planned_.exchange(true))
+    throw primecount_error("max memory: another pi(x) computation is already running");
+
+  is_owner_ = true;
+  return true;
+}
+
+void MaxMemory::unlock()
+{
+  if (is_owner_)
+  {
+    phi_cache_size_ = max_phi_cache_size;
+    max_memory_segments_ = 1;
+    is_planned_ = false;
+    is_owner_ = false;
+  }
+}
+
+MaxMemory::~MaxMemory()
+{
+  unlock();
+}
+
+/// x^(1/3) < y <= z < x^(1/2) is preserved, y and z
+/// are decreased by 20% per step. Decreasing z only
+/// shrinks the FactorTableD & the PiTable of the AC
+/// formula, hence we decrease z before y.
+///
+MaxMemory::MaxMemory(maxint_t x,
+                     int64_t& y,
+                     int64_t& z,
+                     int& threads,
+                     bool is_segmented)
+{
+  if (!lock())
+    return;
+
+  // The backup file and the worker processes
+  // require computing D(x, y) in a single pass.
+  int max_segments = max_factor_table_segments;
+  if (!is_segmented || is_backup() || is_worker())
+    max_segments = 1;
+
+  int64_t x13 = iroot<3>(x);
+  int64_t min_y = std::max(y, (int64_t) 1);
+  min_y = std::min(min_y, x13 + 1);
+  int segments = (max_segments > 1) ? get_factor_table_segments() : 1;
+
+  auto memory = [&]() {
+    return gourdon_bytes(x, y, z, threads, segments, phi_cache_size_);
+  };
+
+  if (memory() > max_memory_)
+    phi_cache_size_ = min_phi_cache_size;
+  while (memory() > max_memory_ && segments < max_segments)
+    segments = std::min(segments * 2, max_segments);
+  while (memory() > max_memory_ && z > y)
+    z = std::max(y, z - std::max(z / 5, (int64_t) 1));
+  while (memory() > max_memory_ && y > min_y)
+  {
+    y = std::max(min_y, y - std::max(y / 5, (int64_t) 1));
+    z = y;
+  }
+  while (memory() > max_memory_ && threads > 1)
+    threads /= 2;
+
+  // After decreasing z and y fewer FactorTableD segments
+  // may fit into the memory limit. Each segment sieves
+  // the interval [0, x / z[ once, so we use as few
+  // segments as possible.
+  segments = (max_segments > 1) ? get_factor_table_segments() : 1;
+  while (memory() > max_memory_ && segments < max_segments)
+    segments = std::min(segments * 2, max_segments);
+
+  max_memory_segments_ = segments;
+
+  if (memory() > max_memory_)
+  {
+    int64_t bytes = memory();
+    unlock();
+    throw_max_memory(bytes);
+  }
+}
+
+/// y >= x^(1/3) is preserved, y is decreased
+/// by 20% per step.
+///
+MaxMemory::MaxMemory(maxint_t x,
+                     int64_t& y,
+                     int& threads)
+{
+  if (!lock())
+    return;
+
+  int64_t x13 = iroot<3>(x);
+  int64_t min_y = std::max(std::min(y, x13), (int64_t) 1);
+
+  auto memory = [&]() {
+    return deleglise_rivat_bytes(x, y, threads, phi_cache_size_);
+  };
+
+  if (memory() > max_memory_)
+    phi_cache_size_ = min_phi_cache_size;
+  while (memory() > max_memory_ && y > min_y)
+    y = std::max(min_y, y - std::max(y / 5, (int64_t) 1));
+  while (memory() > max_memory_ && threads > 1)
+    threads /= 2;
+
+  if (memory() > max_memory_)
+  {
+    int64_t bytes = memory();
+    unlock();
+    throw_max_memory(bytes);
+  }
+}
+
+} // namespace
@@ -0,0 +1,244 @@
+///
+/// @file  numa.cpp
+/// @brief Detect the NUMA nodes and pin the OpenMP threads to
+///        the CPUs of their NUMA node (--numa). We only use the
+///        Linux sysfs and sched_setaffinity() so that primecount
+///        does not depend on libnuma.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <numa.hpp>
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+  #include <dirent.h>
+  #include <sched.h>
+#endif
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace {
+
+bool is_numa_ = false;
+
+/// CPUs of each NUMA node
+std::vector<std::vector<int>> node_cpus_;
+
+/// Parse a sysfs CPU list e.g. "0-15,32-47"
+std::vector<int> parse_cpulist(const std::string& cpulist)
+{
+  std::vector<int> cpus;
+  std::istringstream iss(cpulist);
+  std::string range;
+
+  while (std::getline(iss, range, ','))
+  {
+    std::size_t pos = range.find('-');
+
+    try
+    {
+      int first = std::stoi(range.substr(0, pos));
+      int last = (pos == std::string::npos) ? first : std::stoi(range.substr(pos + 1));
+      for (int cpu = first; cpu <= last; cpu++)
+        cpus.push_back(cpu);
+    }
+    catch (std::exception&)
+    {
+      // Ignore trailing whitespace
+    }
+  }
+
+  return cpus;
+}
+
+/// CPUs the primecount process is allowed to run on
+std::vector<int> process_cpus()
+{
+  std::vector<int> cpus;
+
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET(cpu, &set))
+        cpus.push_back(cpu);
+#endif
+
+  return cpus;
+}
+
+/// Read the NUMA nodes from /sys/devices/system/node.
+/// NUMA nodes without CPUs (memory only) are ignored.
+///
+std::vector<std::vector<int>> detect_nodes()
+{
+  std::vector<std::vector<int>> nodes;
+
+#if defined(__linux__)
+  std::string path = "/sys/devices/system/node";
+  std::vector<int> ids;
+  DIR* dir = opendir(path.c_str());
+
+  if (dir)
+  {
+    while (dirent* entry = readdir(dir))
+    {
+      std::string name = entry->d_name;
+      if (name.size() > 4 &&
+          name.compare(0, 4, "node") == 0 &&
+          name.find_first_not_of("0123456789", 4) == std::string::npos)
+        ids.push_back(std::stoi(name.substr(4)));
+    }
+
+    closedir(dir);
+  }
+
+  std::sort(ids.begin(), ids.end());
+
+  for (int id : ids)
+  {
+    std::ifstream file(path + "/node" + std::to_string(id) + "/cpulist");
+    std::string cpulist;
+
+    if (std::getline(file, cpulist))
+    {
+      std::vector<int> cpus = parse_cpulist(cpulist);
+      if (!cpus.empty())
+        nodes.push_back(cpus);
+    }
+  }
+#endif
+
+  // Single NUMA node fallback
+  if (nodes.empty())
+    nodes.push_back(process_cpus());
+
+  return nodes;
+}
+
+/// Split the CPUs into groups of
+/// (nearly) equal size, for testing.
+///
+std::vector<std::vector<int>> simulate_nodes(int count)
+{
+  std::vector<int> cpus = process_cpus();
+  std::vector<std::vector<int>> nodes(count);
+  std::size_t size = cpus.size();
+
+  for (int i = 0; i < count; i++)
+    for (std::size_t j = size * i / count; j < size * (i + 1) / count; j++)
+      nodes[i].push_back(cpus[j]);
+
+  return nodes;
+}
+
+} // namespace
+
+namespace primecount {
+
+void set_numa(int nodes)
+{
+  if (nodes < 0)
+    throw primecount_error("invalid number of NUMA nodes: " + std::to_string(nodes));
+
+  node_cpus_ = (nodes > 0) ? simulate_nodes(nodes) : detect_nodes();
+  is_numa_ = true;
+}
+
+void disable_numa()
+{
+  is_numa_ = false;
+  node_cpus_.clear();
+}
+
+/// Nested pi(x) computations (e.g. inside the B formula)
+/// run on the thread of the enclosing computation, they
+/// neither pin their thread nor copy their lookup tables.
+///
+bool is_numa()
+{
+  return is_numa_ && !is_nested();
+}
+
+int numa_nodes()
+{
+  return is_numa_ ? (int) node_cpus_.size() : 1;
+}
+
+NumaThread::NumaThread(int threads)
+{
+  if (!is_numa())
+    return;
+
+  int thread_num = 0;
+
+#ifdef _OPENMP
+  thread_num = omp_get_thread_num();
+#endif
+
+  int nodes = numa_nodes();
+  threads = std::max(threads, 1);
+  node_ = (int) ((int64_t) thread_num * nodes / threads);
+  node_ = std::min(node_, nodes - 1);
+
+#if defined(__linux__)
+  const std::vector<int>& cpus = node_cpus_[node_];
+
+  if (cpus.empty())
+    return;
+
+  cpu_set_t old_set;
+  CPU_ZERO(&old_set);
+
+  if (sched_getaffinity(0, sizeof(old_set), &old_set) != 0)
+    return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus)
+    if (cpu < CPU_SETSIZE)
+      CPU_SET(cpu, &set);
+
+  if (sched_setaffinity(0, sizeof(set), &set) == 0)
+  {
+    is_pinned_ = true;
+    old_affinity_.resize(sizeof(old_set));
+    std::memcpy(old_affinity_.data(), &old_set, sizeof(old_set));
+  }
+#endif
+}
+
+/// The OpenMP threads are reused by the other formulas,
+/// hence we restore their previous CPU affinity.
+///
+NumaThread::~NumaThread()
+{
+#if defined(__linux__)
+  if (is_pinned_)
+  {
+    cpu_set_t old_set;
+    std::memcpy(&old_set, old_affinity_.data(), sizeof(old_set));
+    sched_setaffinity(0, sizeof(old_set), &old_set);
+  }
+#endif
+}
+
+} // namespace
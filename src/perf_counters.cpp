@@ -0,0 +1,216 @@
+///
+/// @file  perf_counters.cpp
+/// @brief Count CPU cycles, instructions, last level cache misses
+///        and branch misses of the hot kernels using Linux'
+///        perf_event_open(). Each thread opens its perf events
+///        only once and keeps them open, a PerfCounters object
+///        reads the counters in its constructor and destructor
+///        and adds the difference to the totals of its formula.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <perf_counters.hpp>
+#include <primecount-internal.hpp>
+
+#include <stdint.h>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#if defined(ENABLE_PERF_COUNTERS) && \
+    defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #include <cstring>
+  #define HAVE_PERF_EVENT_OPEN
+#endif
+
+namespace {
+
+using namespace primecount;
+
+std::mutex mutex_;
+std::map<std::string, PerfTotals> totals_;
+
+#if defined(HAVE_PERF_EVENT_OPEN)
+
+const uint64_t events_config[4] =
+{
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/// The perf events of the current thread
+class PerfEvents
+{
+public:
+  ~PerfEvents()
+  {
+    for (int fd : fd_)
+      if (fd >= 0)
+        close(fd);
+  }
+
+  /// Returns false if perf events are unavailable.
+  /// Individual events (e.g. LLC misses inside
+  /// virtual machines) may be unavailable,
+  /// their count is 0.
+  ///
+  bool init()
+  {
+    if (state_ != 0)
+      return state_ > 0;
+
+    state_ = -1;
+
+    for (int i = 0; i < 4; i++)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = events_config[i];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      fd_[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fd_[i] >= 0)
+        state_ = 1;
+    }
+
+    return state_ > 0;
+  }
+
+  void read_counters(uint64_t* values) const
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      values[i] = 0;
+      if (fd_[i] >= 0 &&
+          read(fd_[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t))
+        values[i] = 0;
+    }
+  }
+
+private:
+  int fd_[4] = { -1, -1, -1, -1 };
+  /// 0 = not initialized, 1 = available, -1 = unavailable
+  int state_ = 0;
+};
+
+thread_local PerfEvents events_;
+
+#endif
+
+std::string format(uint64_t n)
+{
+  std::ostringstream oss;
+  if (n < 1000000)
+    oss << n;
+  else
+    oss << std::scientific << std::setprecision(3) << (double) n;
+  return oss.str();
+}
+
+} // namespace
+
+namespace primecount {
+
+#if defined(ENABLE_PERF_COUNTERS)
+
+PerfCounters::PerfCounters(const char* formula) :
+  formula_(formula)
+{
+#if defined(HAVE_PERF_EVENT_OPEN)
+  // The enclosing kernel already counts
+  // the nested pi(x) computations.
+  if (!is_nested() &&
+      events_.init())
+  {
+    events_.read_counters(start_);
+    is_active_ = true;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(HAVE_PERF_EVENT_OPEN)
+  if (!is_active_)
+    return;
+
+  uint64_t stop[4];
+  events_.read_counters(stop);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  PerfTotals& totals = totals_[formula_];
+  totals.cycles += stop[0] - start_[0];
+  totals.instructions += stop[1] - start_[1];
+  totals.llc_misses += stop[2] - start_[2];
+  totals.branch_misses += stop[3] - start_[3];
+  totals.calls += 1;
+#endif
+}
+
+#endif
+
+bool is_perf_counters()
+{
+#if defined(HAVE_PERF_EVENT_OPEN)
+  return events_.init();
+#else
+  return false;
+#endif
+}
+
+std::map<std::string, PerfTotals> get_perf_counters()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return totals_;
+}
+
+void reset_perf_counters()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  totals_.clear();
+}
+
+/// Printed to stderr in order not to
+/// interfere with the result on stdout.
+///
+void print_perf_counters()
+{
+  auto totals = get_perf_counters();
+
+  if (totals.empty())
+    return;
+
+  std::cerr << std::endl;
+  std::cerr << "=== Hardware performance counters ===" << std::endl;
+
+  for (const auto& t : totals)
+  {
+    const PerfTotals& p = t.second;
+    double ipc = p.cycles ? (double) p.instructions / p.cycles : 0;
+
+    std::cerr << t.first << ": cycles = " << format(p.cycles)
+              << ", instructions = " << format(p.instructions)
+              << ", IPC = " << std::fixed << std::setprecision(2) << ipc
+              << ", LLC misses = " << format(p.llc_misses)
+              << ", branch misses = " << format(p.branch_misses)
+              << ", calls = " << p.calls << std::endl;
+    std::cerr.unsetf(std::ios::fixed);
+  }
+}
+
+} // namespace
@@ -28,6 +28,7 @@
 #include <fast_div.hpp>
 #include <imath.hpp>
 #include <macros.hpp>
+#include <max_memory.hpp>
 #include <min.hpp>
 #include <PhiTiny.hpp>
 #include <PiTable.hpp>
@@ -72,11 +73,10 @@ public:
     // S2_hard(x) and D(x) benchmarks from 1e12 to 1e21.
     uint64_t max_x = isqrt(x);
 
-    // The cache (i.e. the sieve array)
-    // uses at most max_megabytes per thread.
-    uint64_t max_megabytes = 16;
+    // The cache (i.e. the sieve array) uses at most
+    // 16 MiB per thread, less if --max-memory is used.
     uint64_t indexes = max_a - PhiTiny::max_a();
-    uint64_t max_bytes = max_megabytes << 20;
+    uint64_t max_bytes = get_phi_cache_size();
     uint64_t max_bytes_per_index = max_bytes / indexes;
     uint64_t numbers_per_byte = 240 / sizeof(sieve_t);
     uint64_t cache_limit = max_bytes_per_index * numbers_per_byte;
@@ -0,0 +1,162 @@
+///
+/// @file  pi_async.cpp
+/// @brief Asynchronous pi(x) computation with progress reporting
+///        and cancellation. The computation runs in a background
+///        thread, cancelling it makes the load balancers of this
+///        computation stop assigning work so that all threads
+///        exit promptly.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <progress.hpp>
+
+#include <stdint.h>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace {
+
+/// Only one asynchronous computation can run at a time
+/// because the backup file and the memory plan are global.
+std::atomic<bool> is_running_(false);
+
+} // namespace
+
+namespace primecount {
+
+struct PiAsync::State
+{
+  std::thread thread;
+  std::atomic<bool> is_finished{false};
+  std::atomic<double> percent{0};
+  std::string res;
+  std::exception_ptr error;
+  Progress progress;
+
+  State(const std::function<void(double)>& callback)
+    : progress([this, callback](double p) {
+        percent = p;
+        if (callback)
+          callback(p);
+      })
+  { }
+};
+
+PiAsync::PiAsync(std::shared_ptr<State> state)
+  : state_(std::move(state))
+{ }
+
+PiAsync::PiAsync(PiAsync&&) noexcept = default;
+
+PiAsync& PiAsync::operator=(PiAsync&& other) noexcept
+{
+  if (this != &other)
+  {
+    if (state_ && state_->thread.joinable())
+    {
+      cancel();
+      state_->thread.join();
+    }
+
+    state_ = std::move(other.state_);
+  }
+
+  return *this;
+}
+
+PiAsync::~PiAsync()
+{
+  if (state_ && state_->thread.joinable())
+  {
+    cancel();
+    state_->thread.join();
+  }
+}
+
+bool PiAsync::poll() const
+{
+  return state_ && state_->is_finished;
+}
+
+std::string PiAsync::wait()
+{
+  if (!state_)
+    throw primecount_error("PiAsync::wait(): no computation");
+
+  if (state_->thread.joinable())
+    state_->thread.join();
+  if (state_->error)
+    std::rethrow_exception(state_->error);
+
+  return state_->res;
+}
+
+void PiAsync::cancel()
+{
+  if (state_)
+    state_->progress.cancel();
+}
+
+double PiAsync::percent() const
+{
+  return state_ ? state_->percent.load() : 0;
+}
+
+PiAsync pi_async(const std::string& x,
+                 const std::function<void(double)>& progress)
+{
+  if (is_running_.exchange(true))
+    throw primecount_error("pi_async(x): another asynchronous computation is still running");
+
+  auto state = std::make_shared<PiAsync::State>(progress);
+  PiAsync::State* s = state.get();
+  int threads = get_num_threads();
+
+  try
+  {
+    state->thread = std::thread([s, x, threads]() {
+      set_progress(&s->progress);
+
+      try
+      {
+        s->res = pi(x, threads);
+        s->progress.set_range(0, 100);
+        s->progress.report(100);
+      }
+      catch (...)
+      {
+        s->error = std::current_exception();
+      }
+
+      set_progress(nullptr);
+      s->is_finished = true;
+      is_running_ = false;
+    });
+  }
+  catch (std::exception& e)
+  {
+    is_running_ = false;
+    throw primecount_error(std::string("pi_async(x): ") + e.what());
+  }
+
+  return PiAsync(std::move(state));
+}
+
+PiAsync pi_async(int64_t x,
+                 const std::function<void(double)>& progress)
+{
+  return pi_async(std::to_string(x), progress);
+}
+
+} // namespace
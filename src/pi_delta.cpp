@@ -0,0 +1,134 @@
+///
+/// @file  pi_delta.cpp
+/// @brief Compute pi(x2) from a known pi(x1) and count the primes
+///        inside [a, b]. If the interval is small it is much
+///        faster to count its primes using the segmented sieve of
+///        Eratosthenes than to compute pi(x) from scratch using
+///        a combinatorial prime counting function algorithm. We
+///        use a simple cost model to choose the faster method.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <primesieve.hpp>
+#include <macros.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace primecount;
+
+namespace {
+
+/// Estimated run time in seconds (single-threaded) of counting
+/// the primes inside [low, high] using primesieve. The cost is
+/// dominated by the sieving distance and by the sieving primes
+/// <= sqrt(high). The constant has been fitted to benchmarks of
+/// primesieve::count_primes() for 10^9 <= high <= 10^18.
+///
+double sieve_cost(int64_t low, int64_t high)
+{
+  double dist = (double) (high - low);
+  double sqrt_high = std::sqrt((double) high);
+  double log_high = std::log((double) std::max(high, (int64_t) 3));
+  return (dist + sqrt_high) * log_high * log_high * 6.5e-13;
+}
+
+/// Estimated run time in seconds (single-threaded) of
+/// computing pi(x) using Xavier Gourdon's algorithm.
+/// Run time: O(x^(2/3) / (log x)^2)
+///
+double pi_cost(int64_t x)
+{
+  double logx = std::log((double) std::max(x, (int64_t) 3));
+  return std::pow((double) x, 2.0 / 3.0) / (logx * logx) * 2.7e-7;
+}
+
+/// Count the primes inside [start, stop] using primesieve
+/// with the given number of threads. primesieve's number
+/// of threads is a global setting, hence we restore
+/// its previous value afterwards.
+///
+int64_t sieve_count(uint64_t start, uint64_t stop, int threads)
+{
+  int old_threads = primesieve::get_num_threads();
+  primesieve::set_num_threads(threads);
+
+  try
+  {
+    int64_t count = (int64_t) primesieve::count_primes(start, stop);
+    primesieve::set_num_threads(old_threads);
+    return count;
+  }
+  catch (...)
+  {
+    primesieve::set_num_threads(old_threads);
+    throw;
+  }
+}
+
+} // namespace
+
+namespace primecount {
+
+/// Count the number of primes <= x2 using pi_x1 = pi(x1).
+/// If x1 is close to x2 we only count the primes inside
+/// ]x1, x2] (or ]x2, x1] if x2 < x1) using primesieve,
+/// else we compute pi(x2) using the prime counting function.
+///
+int64_t pi_delta(int64_t x1, int64_t pi_x1, int64_t x2, int threads)
+{
+  if_unlikely(pi_x1 < 0)
+    throw primecount_error("pi_delta(x1, pi_x1, x2): pi_x1 must be >= 0");
+
+  if (x1 == x2)
+    return pi_x1;
+
+  int64_t low = std::min(x1, x2);
+  int64_t high = std::max(x1, x2);
+
+  if (high < 2)
+    return 0;
+  if (sieve_cost(low, high) >= pi_cost(x2))
+    return pi(x2, threads);
+
+  // Count the primes inside ]low, high]. Note that
+  // primesieve uses multi-threading for large intervals.
+  uint64_t start = (uint64_t) std::max(low, (int64_t) 0) + 1;
+  int64_t count = sieve_count(start, high, threads);
+
+  if (x2 > x1)
+    return pi_x1 + count;
+  else
+    return pi_x1 - count;
+}
+
+/// Count the number of primes inside [a, b].
+/// For small intervals we count the primes using primesieve,
+/// for large intervals we compute pi(b) - pi(a - 1). In the
+/// latter case pi(a - 1) and pi(b) are computed in a single
+/// batch so that they can share their lookup tables.
+///
+int64_t count_primes(int64_t a, int64_t b, int threads)
+{
+  a = std::max(a, (int64_t) 0);
+
+  if (b < 2 || a > b)
+    return 0;
+
+  if (sieve_cost(a, b) < pi_cost(a) + pi_cost(b))
+    return sieve_count(a, b, threads);
+
+  std::vector<int64_t> x = { a - 1, b };
+  std::vector<int64_t> pix = pi(x, threads);
+  return pix[1] - pix[0];
+}
+
+} // namespace
@@ -48,7 +48,7 @@ int64_t pi_legendre(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== pi_legendre(x) ===");
+    print_header("pi_legendre(x)");
     print("pi(x) = phi(x, a) + a - 1");
     print("x", x);
     print("a", a);
@@ -58,6 +58,9 @@ int64_t pi_legendre(int64_t x,
   int64_t phi_xa = phi(x, a, threads, is_print);
   int64_t sum = phi_xa + a - 1;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
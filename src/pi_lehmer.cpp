@@ -51,7 +51,7 @@ int64_t pi_lehmer(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== pi_lehmer(x) ===");
+    print_header("pi_lehmer(x)");
     print("pi(x) = phi(x, a) + a - 1 - P2 - P3");
     print("x", x);
     print("y", y);
@@ -64,6 +64,9 @@ int64_t pi_lehmer(int64_t x,
   int64_t p3 = P3(x, y, a, threads, is_print);
   int64_t sum = phi_xa + a - 1 - p2 - p3;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
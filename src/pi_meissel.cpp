@@ -53,7 +53,7 @@ int64_t pi_meissel(int64_t x,
   if (is_print)
   {
     print("");
-    print("=== pi_meissel(x) ===");
+    print_header("pi_meissel(x)");
     print("pi(x) = phi(x, a) + a - 1 - P2");
     print("x", x);
     print("y", y);
@@ -65,6 +65,9 @@ int64_t pi_meissel(int64_t x,
   int64_t p2 = P2(x, y, a, threads, is_print);
   int64_t sum = phi_xa + a - 1 - p2;
 
+  if (is_print)
+    print_footer();
+
   return sum;
 }
 
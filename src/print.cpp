@@ -1,24 +1,131 @@
 ///
 /// @file  print.cpp
+/// @brief Print the parameters, status and results of the
+///        formulas. In JSON mode (--json) each line of output
+///        is a JSON record, this makes it easy to monitor
+///        long running computations using other programs.
 ///
-/// Copyright (C) 2022 Kim Walisch, <kim.walisch@gmail.com>
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
 ///
 /// This file is distributed under the BSD License. See the COPYING
 /// file in the top level directory.
 ///
 
 #include <print.hpp>
+#include <primecount.hpp>
 #include <primecount-internal.hpp>
+#include <imath.hpp>
 #include <int128_t.hpp>
 #include <stdint.h>
 
+#include <functional>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
 
 namespace {
 
+using namespace primecount;
+
 bool print_ = false;
 bool print_variables_ = false;
+bool print_json_ = false;
+double json_status_time_ = 0;
+std::function<void(const std::string&)> json_callback_;
+
+/// Stack of the formulas that are currently being
+/// computed e.g. "pi_gourdon_64", "D".
+std::vector<std::string> formulas_;
+
+struct ThreadStats
+{
+  int64_t chunks;
+  int64_t segments;
+  double init_secs;
+  double secs;
+};
+
+/// Statistics of the threads of the current formula,
+/// these are added by the threads of different load
+/// balancers (e.g. AC and B run at the same time).
+std::vector<ThreadStats> thread_stats_;
+std::mutex thread_stats_mutex_;
+
+void clear_thread_stats()
+{
+  std::lock_guard<std::mutex> lock(thread_stats_mutex_);
+  thread_stats_.clear();
+}
+
+/// Single-line JSON record: {"type":"...", "key":value, ...}
+class JsonRecord
+{
+public:
+  JsonRecord(const char* type)
+  {
+    json_ << std::fixed << std::setprecision(3);
+    json_ << "{\"type\":\"" << type << '"';
+    if (!formulas_.empty())
+      add_string("formula", formulas_.back());
+  }
+
+  template <typename T>
+  JsonRecord& add(const char* key, T value)
+  {
+    json_ << ",\"" << key << "\":" << value;
+    return *this;
+  }
+
+  JsonRecord& add_string(const char* key, const std::string& value)
+  {
+    json_ << ",\"" << key << "\":\"";
+    for (char c : value)
+    {
+      if (c == '"' || c == '\\')
+        json_ << '\\';
+      json_ << c;
+    }
+    json_ << '"';
+    return *this;
+  }
+
+  JsonRecord& add_threads()
+  {
+    std::lock_guard<std::mutex> lock(thread_stats_mutex_);
+
+    if (thread_stats_.empty())
+      return *this;
+
+    json_ << ",\"threads\":[";
+    for (std::size_t i = 0; i < thread_stats_.size(); i++)
+    {
+      const ThreadStats& t = thread_stats_[i];
+      json_ << (i ? "," : "")
+            << "{\"thread\":" << i
+            << ",\"chunks\":" << t.chunks
+            << ",\"segments\":" << t.segments
+            << ",\"init_secs\":" << t.init_secs
+            << ",\"secs\":" << t.secs << '}';
+    }
+    json_ << ']';
+    return *this;
+  }
+
+  void print()
+  {
+    json_ << '}';
+    if (json_callback_)
+      json_callback_(json_.str());
+    else
+      std::cout << json_.str() << std::endl;
+  }
+
+private:
+  std::ostringstream json_;
+};
 
 bool is_print_variables()
 {
@@ -30,7 +137,7 @@ void print_threads(int threads)
   std::cout << "threads = " << threads << std::endl;
 }
 
-} // naespace
+} // namespace
 
 namespace primecount {
 
@@ -39,6 +146,11 @@ bool is_print()
   return print_;
 }
 
+bool is_print_json()
+{
+  return print_json_;
+}
+
 /// The final combined result is always shown at
 /// the end even if is_print = false. It is only
 /// not shown for partial formulas.
@@ -58,23 +170,94 @@ void set_print_variables(bool print_variables)
   print_variables_ = print_variables;
 }
 
+/// The formulas only print if is_print() = true,
+/// hence JSON mode also enables printing.
+///
+void set_print_json(bool print_json)
+{
+  print_json_ = print_json;
+  print_ = print_json;
+}
+
+/// Public API: pass the JSON records to the callback
+/// instead of printing them to stdout.
+///
+void set_json_callback(const std::function<void(const std::string&)>& callback)
+{
+  json_callback_ = callback;
+  set_print_json(callback != nullptr);
+}
+
 void print_seconds(double seconds)
 {
   std::cout << "Seconds: " << std::fixed << std::setprecision(3) << seconds << std::endl;
 }
 
+/// In JSON mode the text lines
+/// (descriptions) are not printed.
+///
 void print(string_view_t str)
 {
-  std::cout << str << std::endl;
+  if (!is_print_json())
+    std::cout << str << std::endl;
+}
+
+/// "D(x, y)" -> "=== D(x, y) ===". In JSON mode we print a
+/// "start" record instead, all records up to the end of the
+/// formula carry the formula's name e.g. "D".
+///
+void print_header(string_view_t formula)
+{
+  if (!is_print_json())
+    std::cout << "=== " << formula << " ===" << std::endl;
+  else
+  {
+    std::string name(formula);
+    formulas_.push_back(name.substr(0, name.find('(')));
+    clear_thread_stats();
+    JsonRecord("start").print();
+  }
+}
+
+/// End of a formula that does not print its
+/// result using print(str, res, time).
+///
+void print_footer()
+{
+  if (is_print_json() &&
+      !formulas_.empty())
+    formulas_.pop_back();
 }
 
 void print(string_view_t str, maxint_t res)
 {
-  std::cout << str << " = " << res << std::endl;
+  if (!is_print_json())
+    std::cout << str << " = " << res << std::endl;
+  else
+  {
+    JsonRecord("value")
+      .add_string("name", std::string(str))
+      .add("value", res)
+      .print();
+  }
 }
 
 void print(string_view_t str, maxint_t res, double time)
 {
+  if (is_print_json())
+  {
+    JsonRecord("result")
+      .add_string("name", std::string(str))
+      .add("result", res)
+      .add("seconds", get_time() - time)
+      .add_threads()
+      .print();
+
+    clear_thread_stats();
+    print_footer();
+    return;
+  }
+
   // We overwrite the current text line,
   // which could be e.g.:
   // "Status: 99.9999999991%"
@@ -87,6 +270,19 @@ void print(string_view_t str, maxint_t res, double time)
 /// Used by pi_lmo(x), pi_deleglise_rivat(x)
 void print(maxint_t x, int64_t y, int64_t z, int64_t c, int threads)
 {
+  if (is_print_json())
+  {
+    JsonRecord("params")
+      .add("x", x)
+      .add("y", y)
+      .add("z", z)
+      .add("c", c)
+      .add("alpha", get_alpha(x, y))
+      .add("threads", threads)
+      .print();
+    return;
+  }
+
   std::cout << "x = " << x << std::endl;
   std::cout << "y = " << y << std::endl;
   std::cout << "z = " << z << std::endl;
@@ -98,7 +294,17 @@ void print(maxint_t x, int64_t y, int64_t z, int64_t c, int threads)
 /// Only enabled for partial formulas
 void print_vars(maxint_t x, int64_t y, int threads)
 {
-  if (is_print_variables())
+  if (is_print_json())
+  {
+    JsonRecord("params")
+      .add("x", x)
+      .add("y", y)
+      .add("z", x / y)
+      .add("alpha", get_alpha(x, y))
+      .add("threads", threads)
+      .print();
+  }
+  else if (is_print_variables())
   {
     maxint_t z = x / y;
     std::cout << "x = " << x << std::endl;
@@ -113,7 +319,12 @@ void print_vars(maxint_t x, int64_t y, int threads)
 /// Only enabled for partial formulas
 void print_vars(maxint_t x, int64_t y, int64_t c, int threads)
 {
-  if (is_print_variables())
+  if (is_print_json())
+  {
+    int64_t z = (int64_t)(x / y);
+    print(x, y, z, c, threads);
+  }
+  else if (is_print_variables())
   {
     int64_t z = (int64_t)(x / y);
     print(x, y, z, c, threads);
@@ -124,6 +335,21 @@ void print_vars(maxint_t x, int64_t y, int64_t c, int threads)
 /// Used by pi_gourdon(x)
 void print_gourdon(maxint_t x, int64_t y, int64_t z, int64_t k, int threads)
 {
+  if (is_print_json())
+  {
+    JsonRecord("params")
+      .add("x", x)
+      .add("y", y)
+      .add("z", z)
+      .add("k", k)
+      .add("x_star", get_x_star_gourdon(x, y))
+      .add("alpha_y", get_alpha_y(x, y))
+      .add("alpha_z", get_alpha_z(y, z))
+      .add("threads", threads)
+      .print();
+    return;
+  }
+
   std::cout << "x = " << x << std::endl;
   std::cout << "y = " << y << std::endl;
   std::cout << "z = " << z << std::endl;
@@ -134,10 +360,40 @@ void print_gourdon(maxint_t x, int64_t y, int64_t z, int64_t k, int threads)
   print_threads(threads);
 }
 
+/// Used if a memory limit is set (--max-memory)
+void print_max_memory(int64_t predicted_memory)
+{
+  int64_t max_memory = get_max_memory();
+
+  if (max_memory <= 0)
+    return;
+
+  if (is_print_json())
+  {
+    JsonRecord("memory")
+      .add("max_memory", max_memory)
+      .add("predicted_memory", predicted_memory)
+      .print();
+    return;
+  }
+
+  std::cout << "max_memory = " << ceil_div(max_memory, 1 << 20) << " MiB" << std::endl;
+  std::cout << "predicted_memory = " << ceil_div(predicted_memory, 1 << 20) << " MiB" << std::endl;
+}
+
 /// Only enabled for partial formulas
 void print_gourdon_vars(maxint_t x, int64_t y, int threads)
 {
-  if (is_print_variables())
+  if (is_print_json())
+  {
+    JsonRecord("params")
+      .add("x", x)
+      .add("y", y)
+      .add("alpha_y", get_alpha_y(x, y))
+      .add("threads", threads)
+      .print();
+  }
+  else if (is_print_variables())
   {
     std::cout << "x = " << x << std::endl;
     std::cout << "y = " << y << std::endl;
@@ -150,11 +406,53 @@ void print_gourdon_vars(maxint_t x, int64_t y, int threads)
 /// Only enabled for partial formulas
 void print_gourdon_vars(maxint_t x, int64_t y, int64_t z, int64_t k, int threads)
 {
-  if (is_print_variables())
+  if (is_print_json())
+    print_gourdon(x, y, z, k, threads);
+  else if (is_print_variables())
   {
     print_gourdon(x, y, z, k, threads);
     std::cout << std::endl;
   }
 }
 
+/// Used instead of the "Status: 43%" lines. We print
+/// at most 1 status record per second, so that the
+/// output of long running computations remains small.
+///
+void print_json_status(double percent)
+{
+  double time = get_time();
+  double threshold = 1.0;
+
+  if (time - json_status_time_ >= threshold)
+  {
+    json_status_time_ = time;
+    JsonRecord("status")
+      .add("percent", percent)
+      .print();
+  }
+}
+
+/// Final result of the primecount command-line program
+void print_json_result(maxint_t res, double seconds)
+{
+  formulas_.clear();
+  JsonRecord("final")
+    .add("result", res)
+    .add("seconds", seconds)
+    .print();
+}
+
+/// Called by the load balancers once a thread has finished
+/// all its work. Nested pi(x) computations must not call it.
+///
+void add_thread_stats(int64_t chunks,
+                      int64_t segments,
+                      double init_secs,
+                      double secs)
+{
+  std::lock_guard<std::mutex> lock(thread_stats_mutex_);
+  thread_stats_.push_back(ThreadStats{chunks, segments, init_secs, secs});
+}
+
 } // namespace
@@ -0,0 +1,93 @@
+///
+/// @file  progress.cpp
+/// @brief Progress reporting and cancellation of the asynchronous
+///        pi_async(x) computation.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <progress.hpp>
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+
+#include <functional>
+#include <mutex>
+
+namespace {
+
+/// The pi_async(x) computation of the calling thread
+thread_local primecount::Progress* progress_ = nullptr;
+
+} // namespace
+
+namespace primecount {
+
+Progress::Progress(const std::function<void(double)>& callback) :
+  callback_(callback)
+{ }
+
+void Progress::set_range(double begin, double end)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    begin_ = begin;
+    end_ = end;
+  }
+
+  report(0);
+}
+
+/// The callback is called at most every 0.1 seconds (except
+/// when the computation starts or finishes) and the reported
+/// progress never decreases.
+///
+void Progress::report(double percent)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  percent = in_between(0.0, percent, 100.0);
+  double total = begin_ + (end_ - begin_) * percent / 100;
+  double time = get_time();
+
+  if (total > percent_ &&
+      (time - time_ >= 0.1 || total >= 100))
+  {
+    percent_ = total;
+    time_ = time;
+    callback_(total);
+  }
+}
+
+void Progress::cancel()
+{
+  is_cancelled_ = true;
+}
+
+bool Progress::is_cancelled() const
+{
+  return is_cancelled_;
+}
+
+void Progress::check_cancelled() const
+{
+  if (is_cancelled_)
+    throw primecount_error("pi(x) computation has been cancelled");
+}
+
+/// Nested pi(x) computations (e.g. pi_noprint() inside the
+/// B formula) do not report progress, only the outermost
+/// pi(x) computation does.
+///
+Progress* get_progress()
+{
+  return is_nested() ? nullptr : progress_;
+}
+
+void set_progress(Progress* progress)
+{
+  progress_ = progress;
+}
+
+} // namespace
@@ -0,0 +1,115 @@
+///
+/// @file  trace.cpp
+/// @brief Write the load balancing trace (--trace=FILE) to a
+///        CSV file with one line per chunk of work, e.g.:
+///
+///        formula,thread,start,low,segments,segment_size,wait_secs,init_secs,secs
+///        D,0,0.000123,0,1,65536,0.000001,0.000050,0.001200
+///        D,1,0.000130,65536,1,65536,0.000004,0.000051,0.001100
+///
+///        If the file name ends with .json, the trace is written
+///        as a JSON array with one object per chunk.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <trace.hpp>
+#include <primecount.hpp>
+
+#include <stdint.h>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace primecount;
+
+std::string trace_file_;
+std::vector<TraceChunk> chunks_;
+std::mutex mutex_;
+
+bool is_json(const std::string& filename)
+{
+  std::string ext = ".json";
+  return filename.size() >= ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+void write_csv(std::ofstream& file)
+{
+  file << "formula,thread,start,low,segments,segment_size,wait_secs,init_secs,secs\n";
+
+  for (const TraceChunk& c : chunks_)
+    file << c.formula << ',' << c.thread << ',' << c.start << ','
+         << c.low << ',' << c.segments << ',' << c.segment_size << ','
+         << c.wait_secs << ',' << c.init_secs << ',' << c.secs << '\n';
+}
+
+void write_json(std::ofstream& file)
+{
+  file << "[\n";
+
+  for (std::size_t i = 0; i < chunks_.size(); i++)
+  {
+    const TraceChunk& c = chunks_[i];
+    file << "{\"formula\":\"" << c.formula << "\""
+         << ",\"thread\":" << c.thread
+         << ",\"start\":" << c.start
+         << ",\"low\":" << c.low
+         << ",\"segments\":" << c.segments
+         << ",\"segment_size\":" << c.segment_size
+         << ",\"wait_secs\":" << c.wait_secs
+         << ",\"init_secs\":" << c.init_secs
+         << ",\"secs\":" << c.secs << '}'
+         << (i + 1 < chunks_.size() ? ",\n" : "\n");
+  }
+
+  file << "]\n";
+}
+
+} // namespace
+
+namespace primecount {
+
+void set_trace_file(const std::string& filename)
+{
+  trace_file_ = filename;
+  chunks_.clear();
+}
+
+bool is_trace()
+{
+  return !trace_file_.empty();
+}
+
+/// The chunks are added by the threads of different load
+/// balancers (e.g. AC and B run at the same time).
+///
+void add_trace_chunk(const TraceChunk& chunk)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  chunks_.push_back(chunk);
+}
+
+void write_trace()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream file(trace_file_, std::ios::trunc);
+  file << std::fixed << std::setprecision(6);
+
+  if (is_json(trace_file_))
+    write_json(file);
+  else
+    write_csv(file);
+
+  if (!file.flush())
+    throw primecount_error("failed to write trace file: " + trace_file_);
+}
+
+} // namespace
@@ -0,0 +1,394 @@
+///
+/// @file  tune.cpp
+/// @brief Measure the fastest alpha tuning factors on the current
+///        machine (--tune) and adjust our default alpha tuning
+///        factors using the resulting tuning profile. The profile
+///        is a plain text file with one line per sampled x:
+///
+///        deleglise-rivat <x> <alpha ratio>
+///        gourdon <x> <alpha_y * alpha_z ratio> <alpha_z>
+///
+///        The alpha ratio is the fastest alpha divided by our
+///        default alpha. Lines starting with # are comments.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <tune.hpp>
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <int128_t.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace primecount;
+
+struct TuneSample
+{
+  double logx;
+  double alpha_ratio;
+  double alpha_z;
+};
+
+std::vector<TuneSample> deleglise_rivat_;
+std::vector<TuneSample> gourdon_;
+
+/// Linear interpolation in log(x), for x outside
+/// of the sampled range we use the nearest sample.
+///
+TuneSample interpolate(const std::vector<TuneSample>& samples,
+                       maxint_t x)
+{
+  double logx = std::log((double) x);
+
+  if (logx <= samples.front().logx)
+    return samples.front();
+  if (logx >= samples.back().logx)
+    return samples.back();
+
+  std::size_t i = 1;
+  while (samples[i].logx < logx)
+    i++;
+
+  const TuneSample& s0 = samples[i - 1];
+  const TuneSample& s1 = samples[i];
+  double t = (logx - s0.logx) / (s1.logx - s0.logx);
+
+  TuneSample res;
+  res.logx = logx;
+  res.alpha_ratio = std::exp(std::log(s0.alpha_ratio) * (1 - t) + std::log(s1.alpha_ratio) * t);
+  res.alpha_z = s0.alpha_z * (1 - t) + s1.alpha_z * t;
+  return res;
+}
+
+/// Run pi(x) (without printing) and return the
+/// fastest time of up to 3 runs. Fast runs are
+/// repeated as their timings are noisy.
+///
+template <typename F>
+double measure(F pi_x)
+{
+  double best = std::numeric_limits<double>::max();
+
+  for (int i = 0; i < 3; i++)
+  {
+    double time = get_time();
+    pi_x();
+    best = std::min(best, get_time() - time);
+
+    if (best >= 0.5)
+      break;
+  }
+
+  return best;
+}
+
+/// Find the fastest factor in a geometric series
+/// of factors around 1, then refine around it.
+///
+template <typename F>
+std::pair<double, double> find_fastest(F time_factor)
+{
+  double best_factor = 1;
+  double best_time = time_factor(1.0);
+
+  for (double factor : { 0.5, 0.7, 1.4, 2.0 })
+  {
+    double time = time_factor(factor);
+    if (time < best_time)
+    {
+      best_time = time;
+      best_factor = factor;
+    }
+  }
+
+  double factor0 = best_factor;
+
+  for (double refine : { 0.85, 1.18 })
+  {
+    double time = time_factor(factor0 * refine);
+    if (time < best_time)
+    {
+      best_time = time;
+      best_factor = factor0 * refine;
+    }
+  }
+
+  return std::make_pair(best_factor, best_time);
+}
+
+TuneSample tune_deleglise_rivat(int64_t x, int threads)
+{
+  set_alpha(-1);
+  double default_alpha = get_alpha_deleglise_rivat(x);
+  double default_time = 0;
+
+  auto fastest = find_fastest([&](double factor)
+  {
+    set_alpha(std::max(1.0, default_alpha * factor));
+    double time = measure([&] { pi_deleglise_rivat_64(x, threads, false); });
+    if (factor == 1.0)
+      default_time = time;
+    return time;
+  });
+
+  // Use the alpha that has actually been used
+  set_alpha(std::max(1.0, default_alpha * fastest.first));
+  double alpha = get_alpha_deleglise_rivat(x);
+  set_alpha(-1);
+
+  std::cout << "x = " << x << ", Deleglise-Rivat: alpha = " << alpha
+            << " (default " << default_alpha << "), "
+            << std::fixed << std::setprecision(3) << fastest.second << " sec"
+            << " (default " << default_time << " sec)" << std::endl;
+  std::cout.unsetf(std::ios::fixed);
+
+  TuneSample sample;
+  sample.logx = std::log((double) x);
+  sample.alpha_ratio = alpha / default_alpha;
+  sample.alpha_z = 1;
+  return sample;
+}
+
+TuneSample tune_gourdon(int64_t x, int threads)
+{
+  set_alpha_y(-1);
+  set_alpha_z(-1);
+  auto default_alpha = get_alpha_gourdon(x);
+  double default_alpha_yz = default_alpha.first * default_alpha.second;
+  double default_time = 0;
+
+  // get_alpha_gourdon() limits the alpha_z of the
+  // profile to alpha_y * alpha_z / 5, hence we only
+  // measure alpha_z values within that limit.
+  auto max_alpha_z = [](double alpha_yz)
+  {
+    return std::max(1.0, alpha_yz / 5);
+  };
+
+  auto time_alpha = [&](double alpha_yz, double alpha_z)
+  {
+    set_alpha_z(std::max(1.0, alpha_z));
+    set_alpha_y(std::max(1.0, alpha_yz / alpha_z));
+    return measure([&] { pi_gourdon_64(x, threads, false); });
+  };
+
+  // 1) Find the fastest alpha_y * alpha_z
+  auto fastest = find_fastest([&](double factor)
+  {
+    double alpha_yz = default_alpha_yz * factor;
+    double alpha_z = std::min(default_alpha.second, max_alpha_z(alpha_yz));
+    double time = time_alpha(alpha_yz, alpha_z);
+    if (factor == 1.0)
+      default_time = time;
+    return time;
+  });
+
+  // 2) Find the fastest alpha_z
+  double alpha_yz = default_alpha_yz * fastest.first;
+  double alpha_z = std::min(default_alpha.second, max_alpha_z(alpha_yz));
+  double best_time = fastest.second;
+
+  for (double z : { 1.0, 1.5, 2.0, 3.0, 4.0 })
+  {
+    if (z == alpha_z ||
+        z > max_alpha_z(alpha_yz))
+      continue;
+
+    double time = time_alpha(alpha_yz, z);
+    if (time < best_time)
+    {
+      best_time = time;
+      alpha_z = z;
+    }
+  }
+
+  // Use the alphas that have actually been used
+  set_alpha_z(std::max(1.0, alpha_z));
+  set_alpha_y(std::max(1.0, alpha_yz / alpha_z));
+  auto alpha = get_alpha_gourdon(x);
+  set_alpha_y(-1);
+  set_alpha_z(-1);
+
+  std::cout << "x = " << x << ", Gourdon: alpha_y = " << alpha.first
+            << ", alpha_z = " << alpha.second << " (default "
+            << default_alpha.first << ", " << default_alpha.second << "), "
+            << std::fixed << std::setprecision(3) << best_time << " sec"
+            << " (default " << default_time << " sec)" << std::endl;
+  std::cout.unsetf(std::ios::fixed);
+
+  TuneSample sample;
+  sample.logx = std::log((double) x);
+  sample.alpha_ratio = (alpha.first * alpha.second) / default_alpha_yz;
+  sample.alpha_z = alpha.second;
+  return sample;
+}
+
+} // namespace
+
+namespace primecount {
+
+std::string default_tune_profile()
+{
+  const char* profile = std::getenv("PRIMECOUNT_PROFILE");
+  if (profile && *profile)
+    return profile;
+
+  const char* home = std::getenv("HOME");
+#if defined(_WIN32)
+  if (!home || !*home)
+    home = std::getenv("USERPROFILE");
+#endif
+
+  if (home && *home)
+    return std::string(home) + "/.primecount_profile";
+  else
+    return ".primecount_profile";
+}
+
+void load_tune_profile(const std::string& filename)
+{
+  std::ifstream file(filename);
+
+  if (!file)
+    return;
+
+  std::vector<TuneSample> deleglise_rivat;
+  std::vector<TuneSample> gourdon;
+  std::string line;
+
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream iss(line);
+    std::string algorithm;
+    std::string x;
+    TuneSample sample;
+    sample.alpha_z = 1;
+
+    if (!(iss >> algorithm >> x >> sample.alpha_ratio))
+      throw primecount_error("invalid tuning profile " + filename + ": " + line);
+
+    sample.logx = std::log((double) to_maxint(x));
+
+    if (algorithm == "deleglise-rivat")
+      deleglise_rivat.push_back(sample);
+    else if (algorithm == "gourdon" && iss >> sample.alpha_z)
+      gourdon.push_back(sample);
+    else
+      throw primecount_error("invalid tuning profile " + filename + ": " + line);
+
+    if (!(sample.alpha_ratio > 0) ||
+        !(sample.alpha_z >= 1))
+      throw primecount_error("invalid tuning profile " + filename + ": " + line);
+  }
+
+  auto by_x = [](const TuneSample& a, const TuneSample& b)
+  {
+    return a.logx < b.logx;
+  };
+
+  std::sort(deleglise_rivat.begin(), deleglise_rivat.end(), by_x);
+  std::sort(gourdon.begin(), gourdon.end(), by_x);
+  deleglise_rivat_ = std::move(deleglise_rivat);
+  gourdon_ = std::move(gourdon);
+}
+
+void clear_tune_profile()
+{
+  deleglise_rivat_.clear();
+  gourdon_.clear();
+}
+
+bool is_tune_profile()
+{
+  return !deleglise_rivat_.empty() ||
+         !gourdon_.empty();
+}
+
+double tuned_alpha_deleglise_rivat(maxint_t x, double alpha)
+{
+  if (deleglise_rivat_.empty())
+    return alpha;
+
+  return alpha * interpolate(deleglise_rivat_, x).alpha_ratio;
+}
+
+double tuned_alpha_yz_gourdon(maxint_t x, double alpha_yz)
+{
+  if (gourdon_.empty())
+    return alpha_yz;
+
+  return alpha_yz * interpolate(gourdon_, x).alpha_ratio;
+}
+
+double tuned_alpha_z_gourdon(maxint_t x, double alpha_z)
+{
+  if (gourdon_.empty())
+    return alpha_z;
+
+  return interpolate(gourdon_, x).alpha_z;
+}
+
+void tune(maxint_t x_max, int threads, const std::string& filename)
+{
+  if (x_max > std::numeric_limits<int64_t>::max())
+    throw primecount_error("--tune: x must be < 2^63");
+
+  // Sample x = 10^10, 10^11, ... <= x_max
+  std::vector<int64_t> xs;
+  for (int64_t x = (int64_t) 1e10; x <= x_max; x *= 10)
+  {
+    xs.push_back(x);
+    if (x > std::numeric_limits<int64_t>::max() / 10)
+      break;
+  }
+
+  if (xs.empty())
+    xs.push_back((int64_t) x_max);
+
+  // Measure relative to our default alphas
+  clear_tune_profile();
+
+  std::ostringstream profile;
+  profile << "# primecount alpha tuning profile, threads = " << threads << "\n";
+  profile << "# deleglise-rivat <x> <alpha ratio>\n";
+  profile << "# gourdon <x> <alpha_y * alpha_z ratio> <alpha_z>\n";
+
+  for (int64_t x : xs)
+  {
+    TuneSample dr = tune_deleglise_rivat(x, threads);
+    TuneSample g = tune_gourdon(x, threads);
+    profile << "deleglise-rivat " << x << " " << dr.alpha_ratio << "\n";
+    profile << "gourdon " << x << " " << g.alpha_ratio << " " << g.alpha_z << "\n";
+  }
+
+  std::ofstream file(filename);
+  if (!(file << profile.str()))
+    throw primecount_error("failed to write tuning profile: " + filename);
+  file.close();
+
+  std::cout << "Tuning profile: " << filename << std::endl;
+  load_tune_profile(filename);
+}
+
+} // namespace
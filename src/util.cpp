@@ -16,6 +16,7 @@
 #include <imath.hpp>
 #include <macros.hpp>
 #include <min.hpp>
+#include <tune.hpp>
 
 #include <algorithm>
 #include <chrono>
@@ -38,6 +39,10 @@ double alpha_y_ = -1;
 // Tuning factor used in Xavier Gourdon's algorithm
 double alpha_z_ = -1;
 
+// Number of segments of the FactorTableD
+// used in Xavier Gourdon's D formula
+int factor_table_segments_ = 1;
+
 /// Truncate a floating point number to 3 digits after the decimal
 /// point. This function is used limit the number of digits after the
 /// decimal point of the alpha tuning factor in order to make it more
@@ -191,6 +196,20 @@ void set_alpha_z(double alpha_z)
     alpha_z_ = truncate3(alpha_z);
 }
 
+/// Split the FactorTableD of the D formula into segments,
+/// more segments use less memory but the D formula sieves
+/// the interval [0, x / z[ once for each segment.
+///
+void set_factor_table_segments(int segments)
+{
+  factor_table_segments_ = std::max(1, segments);
+}
+
+int get_factor_table_segments()
+{
+  return factor_table_segments_;
+}
+
 /// Tuning factor used in the Lagarias-Miller-Odlyzko
 /// and Deleglise-Rivat algorithms.
 ///
@@ -302,6 +321,9 @@ double get_alpha_deleglise_rivat(maxint_t x)
       double logx3 = logx * logx * logx;
       alpha = a * logx3 + b * logx2 + c * logx + d;
     }
+
+    // Use the machine's tuning profile (--tune)
+    alpha = tuned_alpha_deleglise_rivat(x, alpha);
   }
 
   // Preserve 3 digits after decimal point
@@ -350,6 +372,10 @@ std::pair<double, double> get_alpha_gourdon(maxint_t x)
     alpha_yz = a * logx3 + b * logx2 + c * logx + d;
   }
 
+  // Use the machine's tuning profile (--tune)
+  if (alpha_y < 1)
+    alpha_yz = tuned_alpha_yz_gourdon(x, alpha_yz);
+
   // Use default alpha_z
   if (alpha_z < 1)
   {
@@ -376,8 +402,10 @@ std::pair<double, double> get_alpha_gourdon(maxint_t x)
     // be in the C1 algorithm. Hence for computations >= 10^23 using
     // an alpha_z > 1 will likely improve performance.
     alpha_z = 2;
+    alpha_z = tuned_alpha_z_gourdon(x, alpha_z);
 
-    // alpha_z should be significantly smaller than alpha_y
+    // alpha_z should be significantly smaller than alpha_y,
+    // this also applies to the tuning profile's alpha_z.
     alpha_z = in_between(1, alpha_yz / 5, alpha_z);
   }
 
@@ -20,6 +20,7 @@
 
 // %ebx bit flags
 #define bit_AVX512F (1 << 16)
+#define bit_AVX512DQ (1 << 17)
 
 // %ecx bit flags
 #define bit_AVX512_VPOPCNTDQ (1 << 14)
@@ -79,18 +80,8 @@ uint64_t get_xcr0()
 #endif
 }
 
-} // namespace
-
-namespace primecount {
-
-bool has_cpuid_popcnt()
-{
-  int abcd[4];
-  run_cpuid(1, 0, abcd);
-  return (abcd[2] & bit_POPCNT) == bit_POPCNT;
-}
-
-bool has_cpuid_avx512_vpopcnt()
+/// Check if the OS supports the AVX512 (ZMM) registers
+bool has_os_avx512()
 {
   int abcd[4];
 
@@ -111,9 +102,26 @@ bool has_cpuid_avx512_vpopcnt()
     return false;
 
   // Check AVX512 OS support
-  if ((xcr0 & zmm_mask) != zmm_mask)
+  return (xcr0 & zmm_mask) == zmm_mask;
+}
+
+} // namespace
+
+namespace primecount {
+
+bool has_cpuid_popcnt()
+{
+  int abcd[4];
+  run_cpuid(1, 0, abcd);
+  return (abcd[2] & bit_POPCNT) == bit_POPCNT;
+}
+
+bool has_cpuid_avx512_vpopcnt()
+{
+  if (!has_os_avx512())
     return false;
 
+  int abcd[4];
   run_cpuid(7, 0, abcd);
 
   // AVX512F, AVX512VPOPCNTDQ
@@ -121,4 +129,17 @@ bool has_cpuid_avx512_vpopcnt()
           (abcd[2] & bit_AVX512_VPOPCNTDQ) == bit_AVX512_VPOPCNTDQ);
 }
 
+bool has_cpuid_avx512_dq()
+{
+  if (!has_os_avx512())
+    return false;
+
+  int abcd[4];
+  run_cpuid(7, 0, abcd);
+
+  // AVX512F, AVX512DQ
+  return ((abcd[1] & bit_AVX512F) == bit_AVX512F &&
+          (abcd[1] & bit_AVX512DQ) == bit_AVX512DQ);
+}
+
 } // namespace
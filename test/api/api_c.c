@@ -97,6 +97,16 @@ int main(void)
   printf("primecount_pi_str(%s) = %s", in, out);
   check(strcmp(out, "37607912018") == 0);
 
+  int64_t xs[4] = { (int64_t) 1e12, 1000, (int64_t) 1e10, -1 };
+  int64_t pixs[4];
+  int ret = primecount_pi_batch(xs, pixs, 4);
+  printf("primecount_pi_batch(1e12, 1000, 1e10, -1) = %"PRId64", %"PRId64", %"PRId64", %"PRId64, pixs[0], pixs[1], pixs[2], pixs[3]);
+  check(ret == 0 &&
+        pixs[0] == 37607912018 &&
+        pixs[1] == 168 &&
+        pixs[2] == 455052511 &&
+        pixs[3] == 0);
+
   printf("\n");
   printf("All tests passed successfully!\n");
 
@@ -0,0 +1,72 @@
+///
+/// @file   count_primes.cpp
+/// @brief  Test count_primes(a, b) which counts the
+///         primes inside [a, b].
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  // Small intervals are sieved, large intervals
+  // are computed using pi(b) - pi(a - 1).
+  int64_t dists[] = { 0, 1, 1000, 1000000, 100000000, 10000000000 };
+
+  for (int64_t dist : dists)
+  {
+    std::uniform_int_distribution<int64_t> dist_a(-1000, (int64_t) 1e11);
+
+    for (int i = 0; i < 5; i++)
+    {
+      int64_t a = dist_a(gen);
+      int64_t b = a + dist;
+      int64_t res = count_primes(a, b);
+      std::cout << "count_primes(" << a << ", " << b << ") = " << res;
+      check(res == pi(b) - pi(a - 1));
+    }
+  }
+
+  // Prime bounds are included
+  int64_t res = count_primes(2, 2);
+  std::cout << "count_primes(2, 2) = " << res;
+  check(res == 1);
+
+  res = count_primes(7, 11);
+  std::cout << "count_primes(7, 11) = " << res;
+  check(res == 2);
+
+  res = count_primes(100, 10);
+  std::cout << "count_primes(100, 10) = " << res;
+  check(res == 0);
+
+  res = count_primes(1000000000000, 1000001000000);
+  std::cout << "count_primes(1000000000000, 1000001000000) = " << res;
+  check(res == 36249);
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
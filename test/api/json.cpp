@@ -0,0 +1,165 @@
+///
+/// @file   json.cpp
+/// @brief  Test the machine-readable JSON output of the
+///         formulas of the pi(x) computation.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <backup.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+bool contains(const std::string& str, const std::string& substr)
+{
+  return str.find(substr) != std::string::npos;
+}
+
+/// Find the result record of the formula
+std::string find_result(const std::vector<std::string>& records,
+                        const std::string& formula)
+{
+  for (const std::string& record : records)
+    if (contains(record, "\"type\":\"result\"") &&
+        contains(record, "\"formula\":\"" + formula + "\""))
+      return record;
+
+  return std::string();
+}
+
+/// Each record belongs to one of the formulas of
+/// pi_gourdon_64(x) or to pi_gourdon_64(x) itself.
+bool is_valid_formula(const std::vector<std::string>& records)
+{
+  std::string key = "\"formula\":\"";
+
+  for (const std::string& record : records)
+  {
+    std::size_t pos = record.find(key);
+    if (pos == std::string::npos)
+    {
+      std::cout << "Missing formula: " << record;
+      return false;
+    }
+
+    pos += key.size();
+    std::string formula = record.substr(pos, record.find('"', pos) - pos);
+    if (formula != "pi_gourdon_64" && formula != "Sigma" &&
+        formula != "Phi0" && formula != "AC" &&
+        formula != "B" && formula != "D")
+    {
+      std::cout << "Invalid formula: " << record;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main()
+{
+  std::vector<std::string> records;
+
+  set_json_callback([&](const std::string& record) {
+    records.push_back(record);
+  });
+
+  int64_t res = pi((int64_t) 1e13);
+  std::cout << "pi(10^13) = " << res;
+  check(res == 346065536839LL);
+
+  std::cout << "JSON records = " << records.size();
+  check(!records.empty());
+
+  bool is_valid = true;
+  for (const std::string& record : records)
+    is_valid = is_valid && record.front() == '{' &&
+                           record.back() == '}' &&
+                           !contains(record, "\n");
+
+  std::cout << "Single-line JSON objects";
+  check(is_valid);
+
+  for (std::string formula : { "Sigma", "Phi0", "AC", "B", "D" })
+  {
+    std::string record = find_result(records, formula);
+    std::cout << "Result record of " << formula;
+    check(contains(record, "\"seconds\":"));
+  }
+
+  for (std::string formula : { "AC", "D" })
+  {
+    std::string record = find_result(records, formula);
+    std::cout << "Thread statistics of " << formula;
+    check(contains(record, "\"threads\":[{\"thread\":0,\"chunks\":") &&
+          contains(record, "\"init_secs\":"));
+  }
+
+  std::cout << "Formula names of all records";
+  check(is_valid_formula(records));
+
+  // The nested pi(x) computations of the B formula
+  // (computed using pi_gourdon_64 for x = 10^15) must
+  // not add their threads to the statistics.
+  records.clear();
+  res = pi((int64_t) 1e15);
+  std::cout << "pi(10^15) = " << res;
+  check(res == 29844570422669LL);
+  std::cout << "No thread statistics of B";
+  check(!contains(find_result(records, "B"), "\"threads\""));
+
+  // When resuming from the backup file the formulas are
+  // not computed, only their value records are printed.
+  std::string filename = "json_backup.txt";
+  std::remove(filename.c_str());
+  set_backup_file(filename);
+  pi((int64_t) 1e13);
+  records.clear();
+  res = pi((int64_t) 1e13);
+  set_backup_file("");
+  std::remove(filename.c_str());
+  std::cout << "pi(10^13) resumed from backup = " << res;
+  check(res == 346065536839LL);
+
+  int starts = 0;
+  for (const std::string& record : records)
+    starts += contains(record, "\"type\":\"start\"");
+
+  std::cout << "Start records after resuming = " << starts;
+  check(starts == 1 && is_valid_formula(records));
+
+  // The batch D formula prints the results of all x
+  records.clear();
+  std::vector<int64_t> pix = pi(std::vector<int64_t>{ (int64_t) 9e12, (int64_t) 1e13 });
+  std::cout << "pi({9 * 10^12, 10^13}) = {" << pix[0] << ", " << pix[1] << "}";
+  check(pix[1] == 346065536839LL && is_valid_formula(records));
+
+  set_json_callback(nullptr);
+  records.clear();
+  res = pi((int64_t) 1e11);
+  std::cout << "pi(10^11) = " << res;
+  check(res == 4118054813LL && records.empty());
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
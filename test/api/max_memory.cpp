@@ -0,0 +1,182 @@
+///
+/// @file   max_memory.cpp
+/// @brief  Test the memory limit (--max-memory=BYTES). pi(x)
+///         must return the correct result with a tight memory
+///         limit and the predicted memory usage must not
+///         exceed the memory limit.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <max_memory.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int64_t x = (int64_t) 1e14;
+  int64_t pix = 3204941750802LL;
+  int threads = 2;
+
+  std::cout << "get_max_memory() = " << get_max_memory();
+  check(get_max_memory() == 0);
+
+  // Without memory limit y and z are not modified
+  int64_t y = 100000;
+  int64_t z = 300000;
+  int t = threads;
+  {
+    MaxMemory max_memory(x, y, z, t);
+    std::cout << "No memory limit: y = " << y << ", z = " << z;
+    check(y == 100000 && z == 300000 && t == threads);
+  }
+
+  int64_t memory = gourdon_memory(x, y, z, threads);
+  std::cout << "gourdon_memory(" << x << ") = " << memory;
+  check(memory > 0);
+
+  // Memory limit smaller than the default memory usage
+  int64_t limit = memory * 3 / 4;
+  set_max_memory(limit);
+  std::cout << "get_max_memory() = " << get_max_memory();
+  check(get_max_memory() == limit);
+
+  {
+    MaxMemory max_memory(x, y, z, t);
+    memory = gourdon_memory(x, y, z, t);
+    std::cout << "Memory limit " << limit << ": gourdon_memory = " << memory;
+    check(memory <= limit);
+  }
+
+  int64_t res = pi_gourdon_64(x, threads, false);
+  std::cout << "pi_gourdon_64(" << x << ") = " << res;
+  check(res == pix);
+
+  y = 200000;
+  t = threads;
+  memory = deleglise_rivat_memory(x, y, threads);
+  limit = memory * 3 / 4;
+  set_max_memory(limit);
+
+  {
+    MaxMemory max_memory(x, y, t);
+    memory = deleglise_rivat_memory(x, y, t);
+    std::cout << "Memory limit " << limit << ": deleglise_rivat_memory = " << memory;
+    check(memory <= limit);
+  }
+
+  res = pi_deleglise_rivat_64(x, threads, false);
+  std::cout << "pi_deleglise_rivat_64(" << x << ") = " << res;
+  check(res == pix);
+
+  // The FactorTableD dominates the memory usage, it
+  // must be split into segments before decreasing z.
+  {
+    int64_t x2 = (int64_t) 1e18;
+    y = 20000000;
+    z = 400000000;
+    t = 1;
+    set_max_memory(0);
+    memory = gourdon_memory(x2, y, z, t);
+    limit = memory * 2 / 3;
+    set_max_memory(limit);
+    MaxMemory max_memory(x2, y, z, t);
+    memory = gourdon_memory(x2, y, z, t);
+    std::cout << "Memory limit " << limit << ": FactorTableD segments = " << get_max_memory_segments();
+    check(get_max_memory_segments() > 1 && z == 400000000 && memory <= limit);
+  }
+
+  // After decreasing z and y the FactorTableD is small,
+  // hence it must not be split into segments anymore.
+  {
+    int64_t x2 = (int64_t) 1e16;
+    y = 1000000;
+    z = 4000000;
+    t = 1;
+    limit = 16000000;
+    set_max_memory(limit);
+    MaxMemory max_memory(x2, y, z, t);
+    memory = gourdon_memory(x2, y, z, t);
+    std::cout << "Memory limit " << limit << ": y = " << y << ", z = " << z
+              << ", FactorTableD segments = " << get_max_memory_segments();
+    check(get_max_memory_segments() == 1 && memory <= limit);
+
+    // The memory limit cannot be shared by
+    // concurrent pi(x) computations.
+    try
+    {
+      MaxMemory max_memory2(x2, y, z, t);
+      std::cout << "Concurrent memory plan   ERROR\n";
+      std::exit(1);
+    }
+    catch (const primecount_error& e)
+    {
+      std::cout << "Concurrent memory plan: " << e.what() << "   OK\n";
+    }
+  }
+
+  std::cout << "FactorTableD segments after pi(x) = " << get_max_memory_segments();
+  check(get_max_memory_segments() == 1);
+
+  for (int64_t i = 1; i <= 20; i++)
+  {
+    int64_t xi = x / (i * 997);
+    set_max_memory(0);
+    int64_t res1 = pi(xi, threads);
+    set_max_memory(24 << 20);
+    int64_t res2 = pi(xi, threads);
+    std::cout << "pi(" << xi << ") with max memory 24 MiB = " << res2;
+    check(res1 == res2);
+  }
+
+  // Memory limit too small
+  try
+  {
+    set_max_memory(1 << 20);
+    res = pi(x, threads);
+    std::cout << "pi(" << x << ") with max memory 1 MiB = " << res << "   ERROR\n";
+    std::exit(1);
+  }
+  catch (const primecount_error& e)
+  {
+    std::cout << "pi(" << x << ") with max memory 1 MiB: " << e.what() << "   OK\n";
+  }
+
+  try
+  {
+    set_max_memory(-1);
+    std::cout << "set_max_memory(-1)   ERROR\n";
+    std::exit(1);
+  }
+  catch (const primecount_error& e)
+  {
+    std::cout << "set_max_memory(-1): " << e.what() << "   OK\n";
+  }
+
+  set_max_memory(0);
+  std::cout << "set_max_memory(0): " << get_max_memory();
+  check(get_max_memory() == 0 && get_phi_cache_size() == (16 << 20));
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+///
+/// @file   pi_async.cpp
+/// @brief  Test the asynchronous pi_async(x) computation
+///         including progress reporting and cancellation.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  double last = -1;
+  bool is_monotonic = true;
+
+  auto progress = [&](double percent) {
+    is_monotonic = is_monotonic && percent > last;
+    last = percent;
+  };
+
+  {
+    PiAsync handle = pi_async((int64_t) 1e12, progress);
+    std::string res = handle.wait();
+    std::cout << "pi_async(10^12) = " << res;
+    check(res == "37607912018");
+    check(handle.poll());
+    std::cout << "Progress = " << handle.percent() << "%";
+    check(handle.percent() == 100 && last == 100 && is_monotonic);
+  }
+
+  {
+    PiAsync handle = pi_async("1000");
+    std::cout << "pi_async(1000) = " << handle.wait();
+    check(handle.percent() == 100);
+  }
+
+  {
+    PiAsync handle = pi_async("100000000000000000000");
+
+    try
+    {
+      pi_async("1000");
+      std::cout << "Second concurrent pi_async(x)";
+      check(false);
+    }
+    catch (primecount_error& e)
+    {
+      std::cout << "Second concurrent pi_async(x): " << e.what();
+      check(true);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto t1 = std::chrono::steady_clock::now();
+    handle.cancel();
+
+    try
+    {
+      handle.wait();
+      std::cout << "Cancel pi_async(10^20)";
+      check(false);
+    }
+    catch (primecount_error& e)
+    {
+      auto t2 = std::chrono::steady_clock::now();
+      double secs = std::chrono::duration<double>(t2 - t1).count();
+      std::cout << "Cancel pi_async(10^20): " << e.what() << " after " << secs << " sec";
+      check(secs < 30);
+    }
+  }
+
+  // The B formula computes nested pi(x) computations inside
+  // its OpenMP parallel region, these must neither reset the
+  // progress nor throw when the computation is cancelled.
+  {
+    double max_b = 0;
+    PiAsync handle = pi_async("1000000000000000", [&](double percent) {
+      if (percent < 51)
+        max_b = percent;
+    });
+
+    while (!handle.poll() && handle.percent() < 31)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    handle.cancel();
+
+    try
+    {
+      handle.wait();
+      std::cout << "Cancel pi_async(10^15) during B: finished";
+      check(true);
+    }
+    catch (primecount_error& e)
+    {
+      std::cout << "Cancel pi_async(10^15) during B: " << e.what() << ", progress = " << max_b << "%";
+      check(max_b < 51);
+    }
+  }
+
+  // Cancelling pi_async(x) must not affect
+  // a pi(x) computation running at the same time.
+  {
+    PiAsync handle = pi_async("100000000000000000000");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    handle.cancel();
+    int64_t res = pi((int64_t) 1e13);
+    std::cout << "pi(10^13) while cancelling pi_async(10^20) = " << res;
+    check(res == 346065536839LL);
+
+    try
+    {
+      handle.wait();
+      std::cout << "Cancel pi_async(10^20)";
+      check(false);
+    }
+    catch (primecount_error& e)
+    {
+      std::cout << "Cancel pi_async(10^20): " << e.what();
+      check(true);
+    }
+  }
+
+  // Cancelling a finished computation has no effect
+  {
+    PiAsync handle = pi_async((int64_t) 1e10);
+    handle.wait();
+    handle.cancel();
+    int64_t res = pi((int64_t) 1e13);
+    std::cout << "pi(10^13) after cancelling a finished pi_async(x) = " << res;
+    check(res == 346065536839LL);
+  }
+
+  // After cancelling, the next computation must succeed
+  PiAsync handle = pi_async((int64_t) 1e10);
+  std::cout << "pi_async(10^10) = " << handle.wait();
+  check(handle.wait() == "455052511");
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
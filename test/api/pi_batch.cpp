@@ -0,0 +1,72 @@
+///
+/// @file   pi_batch.cpp
+/// @brief  Test the batch pi(x) function which computes
+///         pi(x) for multiple x that share the same lookup
+///         tables. The results must be identical to pi(x).
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int64_t> dist((int64_t) 1e9, (int64_t) 1e11);
+  std::vector<int64_t> x = { 1000, -5, (int64_t) 1e9, 0 };
+
+  // Many x values that are close to each other so
+  // that they share the same lookup tables.
+  for (int i = 0; i < 20; i++)
+    x.push_back(dist(gen));
+
+  // Duplicate x values
+  x.push_back(x.back());
+  x.push_back((int64_t) 1e9);
+
+  std::vector<int64_t> res = pi(x);
+  check(res.size() == x.size());
+
+  for (std::size_t i = 0; i < x.size(); i++)
+  {
+    std::cout << "pi(" << x[i] << ") = " << res[i];
+    check(res[i] == pi(x[i]));
+  }
+
+  std::vector<std::string> xs = { "1000000000000", "10", "100000000000" };
+  std::vector<std::string> rs = pi(xs);
+  std::cout << "pi(" << xs[0] << ") = " << rs[0];
+  check(rs[0] == "37607912018");
+  std::cout << "pi(" << xs[1] << ") = " << rs[1];
+  check(rs[1] == "4");
+  std::cout << "pi(" << xs[2] << ") = " << rs[2];
+  check(rs[2] == "4118054813");
+
+  std::vector<int64_t> empty;
+  check(pi(empty).empty());
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
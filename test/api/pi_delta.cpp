@@ -0,0 +1,77 @@
+///
+/// @file   pi_delta.cpp
+/// @brief  Test pi_delta(x1, pi_x1, x2) which computes pi(x2)
+///         from a known pi(x1).
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  auto seed = rd();
+  std::mt19937 gen(seed);
+  std::cout << "seed = " << seed << std::endl;
+
+  // Small distances use the sieve, large
+  // distances use the prime counting function.
+  for (int64_t dist : { 0, 1, 1000, 1000000, 100000000 })
+  {
+    std::uniform_int_distribution<int64_t> dist_x(-1000, (int64_t) 1e11);
+
+    for (int i = 0; i < 5; i++)
+    {
+      int64_t x1 = dist_x(gen);
+      int64_t pi_x1 = pi(x1);
+      int64_t x2 = x1 + dist;
+      int64_t res = pi_delta(x1, pi_x1, x2);
+      std::cout << "pi_delta(" << x1 << ", " << pi_x1 << ", " << x2 << ") = " << res;
+      check(res == pi(x2));
+
+      x2 = x1 - dist;
+      res = pi_delta(x1, pi_x1, x2);
+      std::cout << "pi_delta(" << x1 << ", " << pi_x1 << ", " << x2 << ") = " << res;
+      check(res == pi(x2));
+    }
+  }
+
+  int64_t x1 = (int64_t) 1e12;
+  int64_t pi_x1 = 37607912018LL;
+  int64_t x2 = x1 + 1000000;
+  int64_t res = pi_delta(x1, pi_x1, x2);
+  std::cout << "pi_delta(" << x1 << ", " << pi_x1 << ", " << x2 << ") = " << res;
+  check(res == 37607948267LL);
+
+  try
+  {
+    pi_delta(x1, -1, x2);
+    std::cout << "pi_delta(" << x1 << ", -1, " << x2 << ")";
+    check(false);
+  }
+  catch (primecount_error&)
+  { }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,95 @@
+///
+/// @file   cpu_cache.cpp
+/// @brief  Test the CPU cache size detection and the
+///         --L1d-cache=BYTES and --L2-cache=BYTES overrides.
+///         The A + C and D formulas must compute the same
+///         results for any cache size.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <cpu_cache.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int64_t l1d = get_l1d_cache_size();
+  int64_t l2 = get_l2_cache_size();
+
+  std::cout << "L1 data cache size = " << l1d;
+  check(l1d >= (1 << 12) && l1d <= (1 << 30));
+  std::cout << "L2 cache size = " << l2;
+  check(l2 >= l1d && l2 <= (1 << 30));
+
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t AC_x = AC(x, y, z, k, 1);
+  int64_t D_x = 270354670695LL;
+
+  int64_t sizes[][2] = { { 4 << 10, 16 << 10 },
+                         { 32 << 10, 1 << 20 },
+                         { 48 << 10, 2 << 20 },
+                         { 1 << 20, 8 << 20 } };
+
+  for (auto& size : sizes)
+  {
+    set_l1d_cache_size(size[0]);
+    set_l2_cache_size(size[1]);
+    std::cout << "L1d = " << get_l1d_cache_size() << ", L2 = " << get_l2_cache_size();
+    check(get_l1d_cache_size() == size[0] &&
+          get_l2_cache_size() == size[1]);
+
+    for (int threads : { 1, 4 })
+    {
+      int64_t res = AC(x, y, z, k, threads);
+      std::cout << "AC(" << x << "), threads = " << threads << ": " << res;
+      check(res == AC_x);
+
+      res = D(x, y, z, k, Li(x), threads);
+      std::cout << "D(" << x << "), threads = " << threads << ": " << res;
+      check(res == D_x);
+    }
+  }
+
+  set_l1d_cache_size(0);
+  set_l2_cache_size(0);
+  std::cout << "Reset to detected cache sizes";
+  check(get_l1d_cache_size() == l1d &&
+        get_l2_cache_size() == l2);
+
+  try
+  {
+    set_l1d_cache_size(100);
+    std::cout << "set_l1d_cache_size(100)";
+    check(false);
+  }
+  catch (primecount_error& e)
+  {
+    std::cout << "OK: " << e.what() << std::endl;
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
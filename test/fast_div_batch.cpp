@@ -0,0 +1,122 @@
+///
+/// @file  fast_div_batch.cpp
+/// @brief Test fast_div_batch(x, d, q, n) function, the
+///        results must be identical to integer division.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <fast_div_batch.hpp>
+#include <int128_t.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+template <typename T>
+bool test_batch(T x, const uint64_t* d, int n)
+{
+  uint64_t q[DIV_BATCH_SIZE];
+  fast_div_batch(x, d, q, n);
+
+  for (int i = 0; i < n; i++)
+    if (q[i] != (uint64_t) (x / d[i]))
+      return false;
+
+  return true;
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  uint64_t max_q = DIV_BATCH_MAX_QUOTIENT - 1;
+  uint64_t d[DIV_BATCH_SIZE];
+
+  std::cout << "is_fast_div_batch() = " << is_fast_div_batch() << std::endl;
+
+  std::uniform_int_distribution<uint64_t> dist_q(0, max_q);
+  std::uniform_int_distribution<uint64_t> dist_d(1, 1ull << 40);
+  std::uniform_int_distribution<int> dist_n(0, DIV_BATCH_SIZE);
+
+  // Test random x / d < 2^50
+  for (int i = 0; i < 10000; i++)
+  {
+    uint64_t x = dist_q(gen);
+    int n = dist_n(gen);
+
+    for (int j = 0; j < n; j++)
+      d[j] = x / dist_q(gen) + 1;
+
+    std::cout << "fast_div_batch(" << x << ", n = " << n << ")";
+    check(test_batch(x, d, n));
+  }
+
+  // Test x = q * d + r with r = 0, 1, d - 1.
+  // The double quotient is rounded up/down.
+  for (int i = 0; i < 10000; i++)
+  {
+    uint64_t di = dist_d(gen);
+    uint64_t q = dist_q(gen) % (pstd::numeric_limits<uint64_t>::max() / di);
+    uint64_t x0 = q * di;
+
+    for (uint64_t x : { x0, x0 + 1, x0 + di - 1 })
+    {
+      for (int j = 0; j < DIV_BATCH_SIZE; j++)
+        d[j] = di;
+      if (x / di <= max_q)
+      {
+        std::cout << "fast_div_batch(" << x << ", " << di << ")";
+        check(test_batch(x, d, DIV_BATCH_SIZE));
+      }
+    }
+  }
+
+  // Test quotients close to 2^50
+  for (uint64_t di = 1; di < 100000; di += 997)
+  {
+    for (int j = 0; j < DIV_BATCH_SIZE; j++)
+      d[j] = di + j;
+
+    uint64_t x = max_q * di + di - 1;
+    std::cout << "fast_div_batch(" << x << ", " << di << ")";
+    check(test_batch(x, d, DIV_BATCH_SIZE));
+  }
+
+#ifdef HAVE_INT128_T
+
+  std::uniform_int_distribution<uint64_t> dist_u64(0, pstd::numeric_limits<uint64_t>::max());
+
+  // Test x > 2^64, x / d < 2^50
+  for (int i = 0; i < 10000; i++)
+  {
+    uint128_t x = (uint128_t(dist_u64(gen) % (1 << 20)) << 64) | dist_u64(gen);
+    int n = dist_n(gen);
+
+    for (int j = 0; j < n; j++)
+      d[j] = (uint64_t) (x / dist_q(gen)) + 1;
+
+    std::cout << "fast_div_batch(" << x << ", n = " << n << ")";
+    check(test_batch(x, d, n));
+  }
+
+#endif
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
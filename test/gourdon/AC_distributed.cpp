@@ -0,0 +1,123 @@
+///
+/// @file   AC_distributed.cpp
+/// @brief  Test the distributed computation of the A + C formulas
+///         using 1 coordinator process and 3 worker processes
+///         running on localhost. The coordinator computes the C1
+///         formula, the workers compute the A and C2 formulas.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <distributed.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#if !defined(_WIN32)
+  #include <sys/types.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+#if defined(_WIN32)
+  std::cout << "Distributed computing is not supported on Windows" << std::endl;
+#else
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t AC_x = 106430408717LL;
+  int64_t C1_x = -4973651;
+  int workers = 3;
+  std::string port = std::to_string(47000 + getpid() % 1000);
+
+  int fd[2];
+  pid_t pids[3];
+  if (pipe(fd) != 0)
+    std::exit(1);
+
+  // The worker processes must be forked
+  // before OpenMP is initialized.
+  for (int i = 0; i < workers; i++)
+  {
+    pids[i] = fork();
+    if (pids[i] == 0)
+    {
+      try
+      {
+        set_worker("localhost:" + port);
+        set_distributed_timeouts(/* connect */ 5, 30, 600);
+        int64_t sum = (int64_t) AC((maxint_t) x, y, z, k, /* threads */ 2);
+        if (write(fd[1], &sum, sizeof(sum)) != sizeof(sum))
+          _exit(1);
+        _exit(0);
+      }
+      catch (std::exception& e)
+      {
+        // A worker that starts after the other workers have
+        // finished all the work cannot connect to the coordinator.
+        std::cerr << "Worker error: " << e.what() << std::endl;
+        bool is_late = std::string(e.what()).find("failed to connect") != std::string::npos;
+        _exit(is_late ? 2 : 1);
+      }
+    }
+  }
+
+  // The partial sums are merged using maxint_t
+  set_coordinator(port);
+  int64_t res = (int64_t) AC((maxint_t) x, y, z, k, get_num_threads());
+  std::cout << "AC(" << x << ", " << y << ", " << z << ", " << k << ") = " << res;
+  check(res == AC_x);
+
+  int64_t sum = 0;
+
+  for (int i = 0; i < workers; i++)
+  {
+    int status = 0;
+    waitpid(pids[i], &status, 0);
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 2)
+    {
+      std::cout << "Worker " << i << " has not been assigned any work\n";
+      continue;
+    }
+
+    std::cout << "Worker exit status = " << WEXITSTATUS(status);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    int64_t partial = 0;
+    if (read(fd[0], &partial, sizeof(partial)) != sizeof(partial))
+      std::exit(1);
+    sum += partial;
+  }
+
+  // The worker results do not include the C1 formula
+  std::cout << "Sum of the worker results = " << sum;
+  check(sum + C1_x == AC_x);
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+#endif
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+///
+/// @file   D_backup.cpp
+/// @brief  Test resuming the D formula from a backup file.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <backup.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  std::string filename = "D_backup.txt";
+  std::remove(filename.c_str());
+  set_backup_file(filename);
+
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t D_x = 270354670695LL;
+
+  // No backup file exists
+  int64_t res = D(x, y, z, k, Li(x), threads);
+  std::cout << "D(" << x << ", " << y << ", " << z << ", " << k << ") = " << res;
+  check(res == D_x);
+
+  // The backup file contains the finished computation
+  Backup backup = load_backup();
+  std::cout << "D.percent = " << backup["D.percent"];
+  check(backup["D.percent"] == "100");
+  std::cout << "D.sum = " << backup["D.sum"];
+  check(backup["D.sum"] == std::to_string(D_x));
+
+  res = D(x, y, z, k, Li(x), threads);
+  std::cout << "D(" << x << ", " << y << ", " << z << ", " << k << ") = " << res;
+  check(res == D_x);
+
+  // Simulate a crash: [0, 24000000[ has been assigned
+  // to 2 threads but none of them has finished its work.
+  {
+    std::ofstream file(filename);
+    file << "version = " << PRIMECOUNT_VERSION << "\n"
+         << "D.x = " << x << "\n"
+         << "D.y = " << y << "\n"
+         << "D.z = " << z << "\n"
+         << "D.k = " << k << "\n"
+         << "D.interval = 0 " << x / z << "\n"
+         << "D.low = 24000000\n"
+         << "D.segments = 1\n"
+         << "D.segment_size = 240000\n"
+         << "D.sum = 0\n"
+         << "D.unfinished = 0 50 240000 12000000 50 240000\n";
+  }
+
+  res = D(x, y, z, k, Li(x), threads);
+  std::cout << "D(" << x << ", " << y << ", " << z << ", " << k << ") = " << res;
+  check(res == D_x);
+
+  // The backup file contains a different computation
+  // (y + 1), hence it must be ignored.
+  {
+    std::ofstream file(filename);
+    file << "version = " << PRIMECOUNT_VERSION << "\n"
+         << "D.x = " << x << "\n"
+         << "D.y = " << y + 1 << "\n"
+         << "D.z = " << z << "\n"
+         << "D.k = " << k << "\n"
+         << "D.interval = 0 " << x / z << "\n"
+         << "D.low = 47630956\n"
+         << "D.segments = 1\n"
+         << "D.segment_size = 240000\n"
+         << "D.sum = 123\n"
+         << "D.unfinished = \n";
+  }
+
+  res = D(x, y, z, k, Li(x), threads);
+  std::cout << "D(" << x << ", " << y << ", " << z << ", " << k << ") = " << res;
+  check(res == D_x);
+
+  std::remove(filename.c_str());
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+///
+/// @file   D_batch.cpp
+/// @brief  Test the computation of D(x, y) for multiple x
+///         that share the same y, z and k in a single pass
+///         over the sieving interval.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <Vector.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int64_t> dist((int64_t) 5e12, (int64_t) 1e13);
+
+  for (int i = 0; i < 3; i++)
+  {
+    Vector<int64_t> x(5);
+    Vector<int64_t> d_approx(5);
+    x[0] = (int64_t) 1e13;
+    x[1] = x[0] - 1;
+    for (std::size_t j = 2; j < x.size(); j++)
+      x[j] = dist(gen);
+    std::sort(x.begin(), x.end());
+
+    for (std::size_t j = 0; j < x.size(); j++)
+      d_approx[j] = Li(x[j]);
+
+    Vector<int64_t> res = D(x, y, z, k, d_approx, threads);
+
+    for (std::size_t j = 0; j < x.size(); j++)
+    {
+      std::cout << "D(" << x[j] << ", " << y << ", " << z << ", " << k << ") = " << res[j];
+      check(res[j] == D(x[j], y, z, k, d_approx[j], threads));
+    }
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
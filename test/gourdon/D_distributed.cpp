@@ -0,0 +1,248 @@
+///
+/// @file   D_distributed.cpp
+/// @brief  Test the distributed computation of the D formula
+///         using 1 coordinator process and 3 worker processes
+///         running on localhost. We also simulate a worker that
+///         dies while holding a chunk, a client that never sends
+///         its request and a worker that starts after the
+///         coordinator has exited.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <distributed.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#if !defined(_WIN32)
+  #include <netdb.h>
+  #include <sys/socket.h>
+  #include <sys/types.h>
+  #include <sys/wait.h>
+  #include <unistd.h>
+  #include <chrono>
+  #include <thread>
+#endif
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+#if !defined(_WIN32)
+
+/// Connect to the coordinator without sending a request
+int connect_silently(const std::string& port)
+{
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+
+  if (getaddrinfo("localhost", port.c_str(), &hints, &result) != 0)
+    return -1;
+
+  int fd = -1;
+
+  for (addrinfo* ai = result; ai && fd < 0; ai = ai->ai_next)
+  {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+    {
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  freeaddrinfo(result);
+  return fd;
+}
+
+void wait_for(int fd)
+{
+  char c;
+  if (read(fd, &c, 1) != 1)
+    _exit(1);
+}
+
+void notify(int fd, int count)
+{
+  for (int i = 0; i < count; i++)
+    if (write(fd, "x", 1) != 1)
+      _exit(1);
+}
+
+#endif
+
+int main()
+{
+#if defined(_WIN32)
+  std::cout << "Distributed computing is not supported on Windows" << std::endl;
+#else
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t D_x = 270354670695LL;
+  int workers = 3;
+  std::string port = std::to_string(47000 + getpid() % 1000);
+
+  int fd[2];
+  int start[2];
+  int done[2];
+  pid_t pids[3];
+  if (pipe(fd) != 0 ||
+      pipe(start) != 0 ||
+      pipe(done) != 0)
+    std::exit(1);
+
+  // The worker processes must be forked
+  // before OpenMP is initialized.
+  for (int i = 0; i < workers; i++)
+  {
+    pids[i] = fork();
+    if (pids[i] == 0)
+    {
+      try
+      {
+        wait_for(start[0]);
+        set_worker("localhost:" + port);
+        set_distributed_timeouts(/* connect */ 5, 30, 600);
+        int64_t sum = D(x, y, z, k, Li(x), /* threads */ 2);
+        if (write(fd[1], &sum, sizeof(sum)) != sizeof(sum))
+          _exit(1);
+        _exit(0);
+      }
+      catch (std::exception& e)
+      {
+        // A worker that starts after the other workers have
+        // finished all the work cannot connect to the coordinator.
+        std::cerr << "Worker error: " << e.what() << std::endl;
+        bool is_late = std::string(e.what()).find("failed to connect") != std::string::npos;
+        _exit(is_late ? 2 : 1);
+      }
+    }
+  }
+
+  // This worker requests the first chunk and dies without
+  // finishing it, then it connects to the coordinator without
+  // sending a request. Only then the other workers start.
+  pid_t dead_worker = fork();
+  if (dead_worker == 0)
+  {
+    try
+    {
+      set_worker("localhost:" + port);
+      std::string request = "D " + std::to_string(x) + " " + std::to_string(y) + " " +
+                            std::to_string(z) + " " + std::to_string(k) + " 0 " +
+                            std::to_string(x / z) + " 0 0 0 0 0 0";
+      std::string reply = send_request(request);
+      if (reply.compare(0, 5, "work ") != 0)
+        _exit(1);
+      int client = connect_silently(port);
+      if (client < 0)
+        _exit(1);
+      notify(start[1], workers);
+      std::this_thread::sleep_for(std::chrono::seconds(3));
+      close(client);
+      _exit(0);
+    }
+    catch (std::exception& e)
+    {
+      std::cerr << "Dead worker error: " << e.what() << std::endl;
+      _exit(1);
+    }
+  }
+
+  // This worker starts after the coordinator
+  // has exited, it must give up connecting.
+  pid_t late_worker = fork();
+  if (late_worker == 0)
+  {
+    try
+    {
+      wait_for(done[0]);
+      set_worker("localhost:" + port);
+      set_distributed_timeouts(/* connect */ 1, 30, 600);
+      D(x, y, z, k, Li(x), /* threads */ 2);
+      _exit(1);
+    }
+    catch (primecount_error& e)
+    {
+      std::cerr << "Late worker: " << e.what() << std::endl;
+      _exit(0);
+    }
+  }
+
+  // The chunk of the dead worker expires after 2 seconds,
+  // the client that does not send its request is
+  // disconnected after 1 second.
+  set_coordinator(port);
+  set_distributed_timeouts(3600, /* io */ 1, /* chunk */ 2);
+  int64_t res = D(x, y, z, k, Li(x), get_num_threads());
+  std::cout << "D(" << x << ", " << y << ", " << z << ", " << k << ") = " << res;
+  check(res == D_x);
+  notify(done[1], 1);
+
+  int64_t sum = 0;
+
+  for (int i = 0; i < workers; i++)
+  {
+    int status = 0;
+    waitpid(pids[i], &status, 0);
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 2)
+    {
+      std::cout << "Worker " << i << " has not been assigned any work\n";
+      continue;
+    }
+
+    std::cout << "Worker exit status = " << WEXITSTATUS(status);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    int64_t partial = 0;
+    if (read(fd[0], &partial, sizeof(partial)) != sizeof(partial))
+      std::exit(1);
+    sum += partial;
+  }
+
+  // The chunk of the dead worker has been
+  // reassigned to the other workers.
+  std::cout << "Sum of the worker results = " << sum;
+  check(sum == D_x);
+
+  int status = 0;
+  waitpid(dead_worker, &status, 0);
+  std::cout << "Dead worker exit status = " << WEXITSTATUS(status);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  waitpid(late_worker, &status, 0);
+  std::cout << "Late worker exit status = " << WEXITSTATUS(status);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  // Nested pi(x) computations (e.g. inside
+  // the B formula) are computed locally.
+  int64_t pix = pi_noprint((int64_t) 1e14, get_num_threads());
+  std::cout << "Nested pi(10^14) with --coordinator = " << pix;
+  check(pix == 3204941750802LL);
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+#endif
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+///
+/// @file   D_numa.cpp
+/// @brief  Test the D formula in NUMA mode (--numa). On a
+///         single node machine we simulate multiple NUMA nodes,
+///         each simulated node uses its own copy of the PiTable
+///         and FactorTableD lookup tables.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <numa.hpp>
+#include <Vector.hpp>
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t D_x = 270354670695LL;
+
+  set_numa(0);
+  std::cout << "Detected NUMA nodes = " << numa_nodes();
+  check(numa_nodes() >= 1);
+
+  int64_t res = D(x, y, z, k, Li(x), 4);
+  std::cout << "D(" << x << "), detected NUMA nodes: " << res;
+  check(res == D_x);
+
+  for (int nodes : { 1, 2, 3 })
+  {
+    set_numa(nodes);
+    std::cout << "Simulated NUMA nodes = " << numa_nodes();
+    check(numa_nodes() == nodes);
+
+    res = D(x, y, z, k, Li(x), 4);
+    std::cout << "D(" << x << "), " << nodes << " NUMA nodes: " << res;
+    check(res == D_x);
+
+    Vector<int64_t> xs(2);
+    Vector<int64_t> d_approx(2);
+    xs[0] = x - 123456789;
+    xs[1] = x;
+    d_approx[0] = Li(xs[0]);
+    d_approx[1] = Li(xs[1]);
+    Vector<int64_t> batch = D(xs, y, z, k, d_approx, 4);
+    std::cout << "D_batch(" << xs[1] << "), " << nodes << " NUMA nodes: " << batch[1];
+    check(batch[0] == D(xs[0], y, z, k, d_approx[0], 4) && batch[1] == D_x);
+  }
+
+  // Nested pi(x) computations (e.g. inside the
+  // B formula) do not use NUMA mode.
+  set_numa(2);
+  int64_t pix = pi_noprint(x, 1);
+  std::cout << "Nested pi(" << x << "), 2 NUMA nodes: " << pix;
+  check(pix == 346065536839LL && is_numa());
+
+  disable_numa();
+  std::cout << "NUMA mode disabled";
+  check(!is_numa() && numa_nodes() == 1);
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+///
+/// @file   D_segmented.cpp
+/// @brief  Test the D formula using a segmented FactorTableD.
+///         The D formula is computed once for each segment of
+///         the FactorTableD, the sum of all segments must be
+///         identical to D(x, y) using the full FactorTableD.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <StatusS2.hpp>
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t D_x = 270354670695LL;
+
+  std::cout << "get_factor_table_segments() = " << get_factor_table_segments();
+  check(get_factor_table_segments() == 1);
+
+  for (int segments : { 1, 2, 3, 7, 1000 })
+  {
+    set_factor_table_segments(segments);
+    int64_t res = D(x, y, z, k, Li(x), 4);
+    std::cout << "D(" << x << "), " << segments << " factor table segments: " << res;
+    check(res == D_x);
+  }
+
+  set_factor_table_segments(5);
+
+  for (int64_t i = 1; i <= 30; i++)
+  {
+    int64_t xi = x / (i * 1013);
+    set_factor_table_segments(1);
+    int64_t res1 = pi_gourdon_64(xi, 2, false);
+    set_factor_table_segments(5);
+    int64_t res2 = pi_gourdon_64(xi, 2, false);
+    std::cout << "pi_gourdon(" << xi << ") = " << res2;
+    check(res1 == res2);
+  }
+
+  // Each pass over the sieving interval is
+  // scaled to its share of the computation.
+  {
+    int64_t xz = x / z;
+    StatusS2 status(x);
+    status.setPass(0, 4);
+    std::cout << "Status of pass 1/4 at start = " << status.getTotalPercent(0, xz, 0, D_x);
+    check(status.getTotalPercent(0, xz, 0, D_x) == 0);
+    std::cout << "Status of pass 1/4 at end = " << status.getTotalPercent(xz, xz, D_x / 4, D_x / 4);
+    check(status.getTotalPercent(xz, xz, D_x / 4, D_x / 4) == 25);
+    status.setPass(3, 4);
+    std::cout << "Status of pass 4/4 at start = " << status.getTotalPercent(0, xz, 0, D_x / 4);
+    check(status.getTotalPercent(0, xz, 0, D_x / 4) == 75);
+    std::cout << "Status of pass 4/4 at end = " << status.getTotalPercent(xz, xz, D_x / 4, D_x / 4);
+    check(status.getTotalPercent(xz, xz, D_x / 4, D_x / 4) == 100);
+  }
+
+  set_factor_table_segments(0);
+  std::cout << "set_factor_table_segments(0): " << get_factor_table_segments();
+  check(get_factor_table_segments() == 1);
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,56 @@
+///
+/// @file   D_threads.cpp
+/// @brief  Test the D function using many threads. The threads
+///         of LoadBalancerS2 usually get their work without
+///         locking, the sum of all chunks must nevertheless be
+///         exact.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t D_x = 270354670695LL;
+
+  for (int threads : { 2, 3, 8, 16, 32 })
+  {
+    int64_t res = D(x, y, z, k, Li(x), threads);
+    std::cout << "D(" << x << ", " << y << ", " << z << ", " << k << "), threads = " << threads << ": " << res;
+    check(res == D_x);
+
+    #ifdef HAVE_INT128_T
+      int128_t res2 = D((int128_t) x, y, z, k, (int128_t) Li(x), threads);
+      std::cout << "D_128bit(" << x << ", " << y << ", " << z << ", " << k << "), threads = " << threads << ": " << res2;
+      check(res2 == D_x);
+    #endif
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
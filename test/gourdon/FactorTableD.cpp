@@ -45,6 +45,7 @@ int main()
   auto lpf = generate_lpf(z);
   auto mpf = generate_mpf(z);
   auto mu = generate_moebius(z);
+  auto pi = generate_pi(z);
 
   FactorTableD<uint16_t> factorTable(y, z, threads);
   int64_t uint16_max = pstd::numeric_limits<uint16_t>::max();
@@ -87,8 +88,8 @@ int main()
     // 2) INT_MAX      if n is a prime
     // 3) 0            if n has a prime factor > y
     // 4) 0            if moebius(n) = 0
-    // 5) lpf - 1      if moebius(n) = 1
-    // 6) lpf          if moebius(n) = -1
+    // 5) 2 * pi(lpf)      if moebius(n) = 1
+    // 6) 2 * pi(lpf) + 1  if moebius(n) = -1
 
     if (n == 1)
       check(factorTable.is_leaf(i) == uint16_max - 1);
@@ -97,11 +98,71 @@ int main()
     else if (mu[n] == 0)
       check(factorTable.is_leaf(i) == 0);
     else
-      check(lpf[n] == factorTable.is_leaf(i) + (factorTable.mu(i) == 1));
+      check(2 * pi[lpf[n]] + 1 == factorTable.is_leaf(i) + (factorTable.mu(i) == 1));
+
+    // n is a leaf of primes[b] if lpf(n) > primes[b]
+    if (!is_prime && n > 1 && mu[n] != 0)
+    {
+      int64_t b = pi[lpf[n]];
+      std::cout << "is_leaf(" << n << ", b = " << b - 1 << ")";
+      check(factorTable.leaf_bound(b - 1) < factorTable.is_leaf(i));
+      std::cout << "is_leaf(" << n << ", b = " << b << ")";
+      check(factorTable.leaf_bound(b) >= factorTable.is_leaf(i));
+    }
 
     not_coprime:;
   }
 
+  // The 32-bit FactorTableD stores the same lpf indexes
+  FactorTableD<uint32_t> factorTable32(y, z, threads);
+  int64_t max_index = factorTable.to_index(z);
+
+  for (int64_t i = 0; i <= max_index; i++)
+  {
+    if (factorTable.is_leaf(i) < uint16_max - 1 &&
+        factorTable.is_leaf(i) != factorTable32.is_leaf(i))
+    {
+      std::cout << "FactorTableD<uint32_t>.is_leaf(" << i << ") = " << factorTable32.is_leaf(i);
+      check(false);
+    }
+  }
+
+  std::cout << "FactorTableD<uint32_t> == FactorTableD<uint16_t>";
+  check(true);
+
+  // For z > 5 * 10^6 the lpf index of the primes
+  // <= z / 13 does not fit into 16 bits, but only
+  // the primes <= sqrt(z) are stored as lpf.
+  {
+    int64_t y2 = 500000;
+    int64_t z2 = 10000000;
+    FactorTableD<uint16_t> factorTable16(y2, z2, threads);
+    FactorTableD<uint32_t> factorTable32(y2, z2, threads);
+    int64_t uint32_max = pstd::numeric_limits<uint32_t>::max();
+    int64_t max_index = factorTable16.to_index(z2);
+
+    for (int64_t i = 0; i <= max_index; i++)
+    {
+      int64_t leaf16 = factorTable16.is_leaf(i);
+      int64_t leaf32 = factorTable32.is_leaf(i);
+
+      if ((leaf16 < uint16_max - 1 && leaf16 != leaf32) ||
+          (leaf16 >= uint16_max - 1 && leaf32 < uint32_max - 1))
+      {
+        std::cout << "FactorTableD<uint16_t>(" << y2 << ", " << z2 << ").is_leaf(" << i << ") = " << leaf16;
+        check(false);
+      }
+    }
+
+    std::cout << "FactorTableD<uint16_t>(" << y2 << ", " << z2 << ") == FactorTableD<uint32_t>";
+    check(true);
+  }
+
+  // 16-bit entries are used for z <= 1.47 * 10^11
+  int64_t max_z = (int64_t) FactorTableD<uint16_t>::max();
+  std::cout << "FactorTableD<uint16_t>::max() = " << max_z;
+  check(max_z >= (int64_t) 1.4e11 && max_z < 386093ll * 386093ll);
+
   std::cout << std::endl;
   std::cout << "All tests passed successfully!" << std::endl;
 
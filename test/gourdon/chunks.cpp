@@ -0,0 +1,85 @@
+///
+/// @file   chunks.cpp
+/// @brief  Split the sieving interval of the A + C, B and D
+///         formulas into chunks (--low=L --high=H) and check
+///         that the partial sums add up to the full result.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <distributed.hpp>
+#include <gourdon.hpp>
+#include <int128_t.hpp>
+
+#include <stdint.h>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  int64_t max = std::numeric_limits<int64_t>::max();
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  int64_t AC_x = AC(x, y, z, k, threads);
+  int64_t B_x = B(x, y, threads);
+  int64_t D_x = D(x, y, z, k, Li(x), threads);
+
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  for (int i = 0; i < 10; i++)
+  {
+    // Split points may not be multiples of 240
+    std::uniform_int_distribution<int64_t> dist_ac(1, isqrt(x));
+    std::uniform_int_distribution<int64_t> dist_b(isqrt(x), x / y);
+    std::uniform_int_distribution<int64_t> dist_d(1, x / z);
+    int64_t mid_ac = dist_ac(gen);
+    int64_t mid_b = dist_b(gen);
+    int64_t mid_d = dist_d(gen);
+
+    set_chunk(0, mid_ac);
+    int64_t sum = AC(x, y, z, k, threads);
+    set_chunk(mid_ac, max);
+    sum += AC(x, y, z, k, threads);
+    std::cout << "AC(" << x << ") split at " << mid_ac << " = " << sum;
+    check(sum == AC_x);
+
+    set_chunk(0, mid_b);
+    sum = B(x, y, threads);
+    set_chunk(mid_b, max);
+    sum += B(x, y, threads);
+    std::cout << "B(" << x << ") split at " << mid_b << " = " << sum;
+    check(sum == B_x);
+
+    set_chunk(0, mid_d);
+    sum = D(x, y, z, k, Li(x), threads);
+    set_chunk(mid_d, max);
+    sum += D(x, y, z, k, Li(x), threads);
+    std::cout << "D(" << x << ") split at " << mid_d << " = " << sum;
+    check(sum == D_x);
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+///
+/// @file   pi_gourdon_backup.cpp
+/// @brief  Test resuming pi_gourdon(x) from a backup file.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <backup.hpp>
+#include <gourdon.hpp>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  std::string filename = "pi_gourdon_backup.txt";
+  std::remove(filename.c_str());
+  set_backup_file(filename);
+
+  int64_t x = (int64_t) 1e13;
+  int64_t pix = 346065536839LL;
+
+  int64_t res = pi_gourdon_64(x, threads);
+  std::cout << "pi_gourdon_64(" << x << ") = " << res;
+  check(res == pix);
+
+  // The backup file contains the results of all formulas
+  Backup backup = load_backup();
+
+  for (std::string formula : { "Sigma", "Phi0", "AC", "B", "D" })
+  {
+    std::string key = "pi_gourdon." + formula;
+    std::cout << key << " = " << backup[key];
+    check(!backup[key].empty());
+  }
+
+  // Formulas stored in the backup file are not
+  // recomputed, hence if we modify the result of
+  // the D formula pi(x) changes accordingly.
+  int64_t d = std::stoll(backup["pi_gourdon.D"]);
+  backup["pi_gourdon.D"] = std::to_string(d + 1);
+  store_backup(backup);
+
+  res = pi_gourdon_64(x, threads);
+  std::cout << "pi_gourdon_64(" << x << ") = " << res;
+  check(res == pix + 1);
+
+  // The backup file contains a different x,
+  // hence pi(x) is recomputed from scratch.
+  res = pi_gourdon_64(x + 1, threads);
+  std::cout << "pi_gourdon_64(" << x + 1 << ") = " << res;
+  check(res == pix);
+
+  // For x = 10^15 the B formula computes the nested
+  // pi(x / prime) using pi_gourdon_64() in each of its
+  // chunks. Nested computations must not modify the
+  // backup file of the outermost pi(x) computation.
+  std::remove(filename.c_str());
+  int64_t x2 = (int64_t) 1e15;
+  res = pi_gourdon_64(x2, 4);
+  std::cout << "pi_gourdon_64(" << x2 << ") = " << res;
+  check(res == 29844570422669LL);
+
+  backup = load_backup();
+  std::cout << "pi_gourdon.x = " << backup["pi_gourdon.x"];
+  check(backup["pi_gourdon.x"] == std::to_string(x2));
+
+  for (std::string formula : { "Sigma", "Phi0", "AC", "B", "D" })
+  {
+    std::string key = "pi_gourdon." + formula;
+    std::cout << key << " = " << backup[key];
+    check(!backup[key].empty());
+  }
+
+  // The nested pi(x) computations must also
+  // work if the backup file is used.
+  res = pi_gourdon_64(x2, 4);
+  std::cout << "pi_gourdon_64(" << x2 << ") = " << res;
+  check(res == 29844570422669LL);
+
+#ifdef HAVE_INT128_T
+  int128_t res128 = pi_gourdon_128(x, threads);
+  std::cout << "pi_gourdon_128(" << x << ") = " << res128;
+  check(res128 == pix);
+#endif
+
+  std::remove(filename.c_str());
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
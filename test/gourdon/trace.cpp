@@ -0,0 +1,140 @@
+///
+/// @file   trace.cpp
+/// @brief  Test the load balancing trace (--trace=FILE) of the
+///         A + C and D formulas. The chunks of each formula must
+///         cover the sieving interval without gaps or overlaps.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <imath.hpp>
+#include <trace.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+struct Chunk
+{
+  int64_t low;
+  int64_t high;
+};
+
+/// Read the chunks of the formula from the CSV trace file
+std::vector<Chunk> read_chunks(const std::string& filename,
+                               const std::string& formula)
+{
+  std::vector<Chunk> chunks;
+  std::ifstream file(filename);
+  std::string line;
+  std::getline(file, line);
+
+  while (std::getline(file, line))
+  {
+    for (char& c : line)
+      if (c == ',')
+        c = ' ';
+
+    std::istringstream iss(line);
+    std::string name;
+    int thread;
+    double start;
+    int64_t low, segments, segment_size;
+
+    if (iss >> name >> thread >> start >> low >> segments >> segment_size &&
+        name == formula)
+      chunks.push_back(Chunk{low, low + segments * segment_size});
+  }
+
+  std::sort(chunks.begin(), chunks.end(),
+            [](const Chunk& a, const Chunk& b) { return a.low < b.low; });
+
+  return chunks;
+}
+
+bool is_contiguous(const std::vector<Chunk>& chunks)
+{
+  if (chunks.empty() || chunks[0].low != 0)
+    return false;
+
+  for (std::size_t i = 1; i < chunks.size(); i++)
+    if (chunks[i].low != chunks[i - 1].high)
+      return false;
+
+  return true;
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+  std::string filename = "primecount_trace_test.csv";
+
+  set_trace_file(filename);
+  int64_t AC_x = AC(x, y, z, k, threads);
+  int64_t D_x = D(x, y, z, k, Li(x), threads);
+  write_trace();
+
+  std::cout << "D(" << x << ") = " << D_x;
+  check(D_x == 270354670695LL);
+
+  std::ifstream file(filename);
+  std::string header;
+  std::getline(file, header);
+  std::cout << "CSV header = " << header;
+  check(header == "formula,thread,start,low,segments,segment_size,wait_secs,init_secs,secs");
+
+  std::vector<Chunk> chunks = read_chunks(filename, "D");
+  std::cout << "D chunks = " << chunks.size();
+  check(is_contiguous(chunks) && chunks.back().high >= x / z);
+
+  chunks = read_chunks(filename, "AC");
+  std::cout << "AC(" << x << ") = " << AC_x << ", chunks = " << chunks.size();
+  check(is_contiguous(chunks) && chunks.back().high >= isqrt(x));
+
+  // Nested pi(x) computations (e.g. inside
+  // the B formula) must not add their chunks
+  // to the trace.
+  set_trace_file(filename);
+  int64_t pix = pi_noprint(x, threads);
+  write_trace();
+  std::cout << "Nested pi(" << x << ") = " << pix;
+  check(pix == 346065536839LL);
+
+  std::size_t nested_chunks = read_chunks(filename, "AC").size() +
+                              read_chunks(filename, "D").size();
+  std::cout << "Chunks of nested pi(" << x << ") = " << nested_chunks;
+  check(nested_chunks == 0);
+
+  std::remove(filename.c_str());
+  set_trace_file("");
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+///
+/// @file   perf_counters.cpp
+/// @brief  Test the hardware performance counters of the hot
+///         kernels (cmake -DWITH_PERF_COUNTERS=ON). If perf
+///         events are unavailable (or if primecount has been
+///         built without WITH_PERF_COUNTERS) no counts must be
+///         recorded and the results must be correct.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <perf_counters.hpp>
+
+#include <stdint.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  int threads = get_num_threads();
+  int64_t x = (int64_t) 1e13;
+  int64_t y = 107720;
+  int64_t z = 209946;
+  int64_t k = 8;
+
+  int64_t res = D(x, y, z, k, Li(x), threads);
+  std::cout << "D(" << x << ") = " << res;
+  check(res == 270354670695LL);
+
+  res = AC(x, y, z, k, threads);
+  std::cout << "AC(" << x << ") = " << res;
+  check(res == 106430408717LL);
+
+  auto counters = get_perf_counters();
+
+  if (!is_perf_counters())
+  {
+    std::cout << "Perf events unavailable, no counts recorded";
+    check(counters.empty());
+  }
+  else
+  {
+    for (const char* formula : { "D", "A", "C2" })
+    {
+      PerfTotals& p = counters[formula];
+      std::cout << formula << ": calls = " << p.calls
+                << ", cycles = " << p.cycles
+                << ", instructions = " << p.instructions;
+      check(p.calls > 0);
+    }
+
+    print_perf_counters();
+    reset_perf_counters();
+    std::cout << "reset_perf_counters()";
+    check(get_perf_counters().empty());
+
+    // B_thread computes pi(x / prime) using nested pi(x)
+    // computations, these are included in the B counts.
+    int64_t x2 = (int64_t) 1e15;
+    int64_t y2 = 1600000;
+    res = B(x2, y2, threads);
+    counters = get_perf_counters();
+    std::cout << "B(" << x2 << "): only B counted";
+    check(counters.size() == 1 && counters.count("B"));
+    reset_perf_counters();
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
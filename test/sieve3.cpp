@@ -0,0 +1,111 @@
+///
+/// @file   sieve3.cpp
+/// @brief  Test Sieve::cross_off_count() using multiple
+///         segments. Small primes are crossed off using bit
+///         patterns, larger primes using the wheel. The number
+///         of primes that are pre-sieved changes from segment
+///         to segment, hence the same prime is sometimes crossed
+///         off using Sieve::cross_off() and sometimes using
+///         Sieve::cross_off_count().
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <Sieve.hpp>
+#include <generate_primes.hpp>
+#include <imath.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <random>
+
+using std::size_t;
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+int main()
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint64_t> dist_low(1, 1000000);
+  std::uniform_int_distribution<int> dist_size(240, 100000);
+  std::uniform_int_distribution<int> dist_c(3, 60);
+
+  uint64_t low = dist_low(gen) * 240;
+  uint64_t segment_size = Sieve::get_segment_size(dist_size(gen));
+  uint64_t limit = low + segment_size * 10 + dist_size(gen);
+  auto primes = generate_primes<uint64_t>(isqrt(limit));
+
+  Sieve sieve(low, segment_size, primes.size());
+
+  for (; low < limit; low += segment_size)
+  {
+    uint64_t high = std::min(low + segment_size, limit);
+    uint64_t c = std::min((uint64_t) dist_c(gen), primes.size() - 1);
+    sieve.pre_sieve(primes, c, low, high);
+
+    std::vector<char> sieve2(high - low, 1);
+
+    // Numbers divisible by 2, 3, 5 and the first c
+    // primes have been removed by pre_sieve().
+    for (size_t i = 1; i <= c; i++)
+      for (uint64_t j = (low / primes[i]) * primes[i]; j < high; j += primes[i])
+        if (j >= low)
+          sieve2[j - low] = 0;
+
+    for (size_t i = c + 1; i < primes.size(); i++)
+    {
+      uint64_t prime = primes[i];
+      uint64_t prev_count = sieve.get_total_count();
+      sieve.cross_off_count(prime, i);
+      uint64_t cnt1 = prev_count - sieve.get_total_count();
+      uint64_t cnt2 = 0;
+
+      for (uint64_t j = ceil_div(low, prime) * prime; j < high; j += prime)
+      {
+        cnt2 += sieve2[j - low];
+        sieve2[j - low] = 0;
+      }
+
+      std::cout << "[" << low << ", " << high << "[: sieve.cross_off_count(" << prime << ") = " << cnt1;
+      check(cnt1 == cnt2);
+
+      if (i % 8 == 0)
+      {
+        uint64_t stop = (high - low) / 2;
+        uint64_t total = 0;
+        for (uint64_t j = 0; j <= stop; j++)
+          total += sieve2[j];
+
+        sieve.reset_counter();
+        std::cout << "[" << low << ", " << high << "[: sieve.count(" << stop << ") = " << sieve.count(stop);
+        sieve.reset_counter();
+        check(sieve.count(stop) == total);
+      }
+    }
+
+    uint64_t total = 0;
+    for (char is_prime : sieve2)
+      total += is_prime;
+
+    std::cout << "[" << low << ", " << high << "[: sieve.get_total_count() = " << sieve.get_total_count();
+    check(sieve.get_total_count() == total);
+  }
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,169 @@
+///
+/// @file   tune.cpp
+/// @brief  Test the alpha tuning profile (--tune). The default
+///         alpha tuning factors must be adjusted by the ratios
+///         stored in the profile, pi(x) must be correct for
+///         any profile.
+///
+/// Copyright (C) 2024 Kim Walisch, <kim.walisch@gmail.com>
+///
+/// This file is distributed under the BSD License. See the COPYING
+/// file in the top level directory.
+///
+
+#include <primecount.hpp>
+#include <primecount-internal.hpp>
+#include <gourdon.hpp>
+#include <tune.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace primecount;
+
+void check(bool OK)
+{
+  std::cout << "   " << (OK ? "OK" : "ERROR") << "\n";
+  if (!OK)
+    std::exit(1);
+}
+
+/// The test must not write into the source directory
+std::string temp_file(const std::string& name)
+{
+  const char* dir = std::getenv("TMPDIR");
+#if defined(_WIN32)
+  if (!dir)
+    dir = std::getenv("TEMP");
+#endif
+  std::string path = dir ? dir : "/tmp";
+  return path + "/" + name;
+}
+
+bool is_near(double a, double b)
+{
+  return std::abs(a - b) <= b * 0.01;
+}
+
+int main()
+{
+  std::string filename = temp_file("primecount_tune_test.txt");
+  int64_t x1 = (int64_t) 1e12;
+  int64_t x2 = (int64_t) 1e14;
+  int64_t x = (int64_t) 1e13;
+
+  clear_tune_profile();
+  double alpha1 = get_alpha_deleglise_rivat(x1);
+  double alpha = get_alpha_deleglise_rivat(x);
+  auto alpha_gourdon = get_alpha_gourdon(x1);
+
+  {
+    std::ofstream file(filename);
+    file << "# Test profile\n";
+    file << "deleglise-rivat 1e14 1.0\n";
+    file << "deleglise-rivat 10^12 2.0\n";
+    file << "gourdon 1000000000000 0.5 1.5\n";
+  }
+
+  load_tune_profile(filename);
+  std::cout << "is_tune_profile() = " << is_tune_profile();
+  check(is_tune_profile());
+
+  double tuned = get_alpha_deleglise_rivat(x1);
+  std::cout << "tuned alpha(" << x1 << ") = " << tuned;
+  check(is_near(tuned, alpha1 * 2));
+
+  // Interpolated in log(x)
+  tuned = get_alpha_deleglise_rivat(x);
+  std::cout << "tuned alpha(" << x << ") = " << tuned;
+  check(is_near(tuned, alpha * std::sqrt(2.0)));
+
+  tuned = get_alpha_deleglise_rivat(x2 * 100);
+  std::cout << "tuned alpha(" << x2 * 100 << ") = " << tuned;
+  clear_tune_profile();
+  check(tuned == get_alpha_deleglise_rivat(x2 * 100));
+  load_tune_profile(filename);
+
+  // alpha_z of the profile must not exceed alpha_y * alpha_z / 5
+  double alpha_yz = alpha_gourdon.first * alpha_gourdon.second * 0.5;
+  double alpha_z = std::max(1.0, std::min(alpha_yz / 5, 1.5));
+  auto tuned_gourdon = get_alpha_gourdon(x1);
+  std::cout << "tuned alpha_y(" << x1 << ") = " << tuned_gourdon.first
+            << ", alpha_z = " << tuned_gourdon.second;
+  check(is_near(tuned_gourdon.second, alpha_z) &&
+        is_near(tuned_gourdon.first * tuned_gourdon.second, alpha_yz));
+
+  {
+    std::ofstream file(filename);
+    file << "gourdon 1e12 0.5 100\n";
+  }
+
+  load_tune_profile(filename);
+  tuned_gourdon = get_alpha_gourdon(x1);
+  std::cout << "tuned alpha_z(" << x1 << ") with profile alpha_z 100 = " << tuned_gourdon.second;
+  check(tuned_gourdon.second <= std::max(1.0, alpha_yz / 5) + 0.001);
+
+  {
+    std::ofstream file(filename);
+    file << "gourdon 1e12 0.5 1.5\n";
+  }
+
+  load_tune_profile(filename);
+
+  // Explicitly set alphas are not tuned
+  set_alpha_y(3);
+  set_alpha_z(2);
+  tuned_gourdon = get_alpha_gourdon(x1);
+  std::cout << "set_alpha_y(3), set_alpha_z(2): alpha_y = " << tuned_gourdon.first
+            << ", alpha_z = " << tuned_gourdon.second;
+  check(tuned_gourdon.first == 3 && tuned_gourdon.second == 2);
+  set_alpha_y(-1);
+  set_alpha_z(-1);
+
+  int64_t res = pi_gourdon_64(x, 1, false);
+  std::cout << "pi_gourdon(" << x << ") = " << res;
+  check(res == 346065536839LL);
+
+  res = pi_deleglise_rivat_64(x, 1, false);
+  std::cout << "pi_deleglise_rivat(" << x << ") = " << res;
+  check(res == 346065536839LL);
+
+  // Measure a real profile
+  tune((int64_t) 1e10, 1, filename);
+  std::cout << "tune(1e10)";
+  check(is_tune_profile());
+
+  res = pi_gourdon_64(x, 1, false);
+  std::cout << "pi_gourdon(" << x << ") = " << res;
+  check(res == 346065536839LL);
+
+  {
+    std::ofstream file(filename);
+    file << "gourdon 1e12 0.5\n";
+  }
+
+  try
+  {
+    load_tune_profile(filename);
+    std::cout << "Invalid profile";
+    check(false);
+  }
+  catch (primecount_error& e)
+  {
+    std::cout << "OK: " << e.what() << std::endl;
+  }
+
+  std::remove(filename.c_str());
+  clear_tune_profile();
+
+  std::cout << std::endl;
+  std::cout << "All tests passed successfully!" << std::endl;
+
+  return 0;
+}